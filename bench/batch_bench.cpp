@@ -0,0 +1,109 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+// Reflects a synthetic corpus of generated shaders, some of them broken, with
+// WgslReflect::reflectBatch on 1, 2, 4, ... threads, and prints the shaders/s for each thread
+// count with its speedup over one thread. The first line is the corpus reflected one shader at a
+// time with a new WgslReflect each, for comparison. Every batch is checked against the one on a
+// single thread.
+//
+//   wgsl_batch_bench [--threads <max>] [--shaders <count>]
+
+#include "../wgsl_reflect.h"
+#include "shader_generator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+bool same(const std::vector<WgslReflect::ShaderReflection> &a, const std::vector<WgslReflect::ShaderReflection> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].error != b[i].error || a[i].bindGroups != b[i].bindGroups ||
+            a[i].entryPoints.size() != b[i].entryPoints.size())
+            return false;
+    }
+    return true;
+}
+}
+
+int main(int argc, char **argv) {
+    size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t count = 512;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            maxThreads = std::max(std::atoi(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--shaders") == 0 && i + 1 < argc) {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--threads <max>] [--shaders <count>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> shaders;
+    for (size_t i = 0; i < count; ++i) {
+        ShaderGenerator::Options options;
+        options.seed = i + 1;
+        options.structs = 4 + i % 16;
+        options.bindings = 4 + i % 32;
+        options.functions = 4 + i % 16;
+        shaders.push_back(ShaderGenerator(options).generate());
+        // Every 64th shader is cut off in the middle of a declaration.
+        if (i % 64 == 63)
+            shaders.back().resize(shaders.back().size() / 2);
+    }
+    std::vector<WgslReflect::ShaderSource> sources;
+    for (const auto &shader: shaders)
+        sources.push_back({shader});
+
+    auto start = Clock::now();
+    size_t failed = 0;
+    for (const auto &shader: shaders) {
+        try {
+            WgslReflect reflect(shader);
+            reflect.getBindGroups();
+        } catch (const std::exception &) {
+            failed++;
+        }
+    }
+    const double serial = double(count) / std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("%zu shaders, %zu broken\n", count, failed);
+    std::printf("threads,shaders_per_sec,speedup\n");
+    std::printf("one-at-a-time,%.0f,-\n", serial);
+
+    std::vector<WgslReflect::ShaderReflection> expected;
+    bool mismatch = false;
+    double single = 0;
+    for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        WgslReflect::BatchOptions options;
+        options.threads = threads;
+        start = Clock::now();
+        auto results = WgslReflect::reflectBatch(sources, options);
+        const double rate = double(count) / std::chrono::duration<double>(Clock::now() - start).count();
+        if (threads == 1) {
+            single = rate;
+            expected = std::move(results);
+        } else if (!same(results, expected)) {
+            mismatch = true;
+        }
+        std::printf("%zu,%.0f,%.2f\n", threads, rate, rate / single);
+        if (threads == maxThreads)
+            break;
+    }
+
+    if (mismatch) {
+        std::fprintf(stderr, "A batch on several threads differed from the one on a single thread\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+// Reflects a set of generated shaders without a cache, fully and declarations only as the cache
+// does, through a ReflectionCache in an empty directory, which misses and stores every shader,
+// and through the same cache again, which hits. For scale it also times opening and mapping the
+// cached files without loading them, the floor of a warm cache. The bodies of every hit are
+// parsed after, to check they still come from the source.
+//
+//   wgsl_cache_bench [--shaders <count>] [--dir <directory>]
+
+#include "../wgsl_reflection_cache.h"
+#include "../wgsl_mapped_file.h"
+#include "shader_generator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace {
+template<typename F>
+double usPerShader(size_t shaders, F &&run) {
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / double(shaders);
+}
+}
+
+int main(int argc, char **argv) {
+    size_t count = 64;
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("wgsl_cache_bench." + std::to_string(std::random_device()()));
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--shaders") == 0 && i + 1 < argc) {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--shaders <count>] [--dir <directory>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> shaders;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        ShaderGenerator::Options options;
+        options.seed = i + 1;
+        options.structs = 16;
+        options.bindings = 16;
+        options.functions = 32;
+        shaders.push_back(ShaderGenerator(options).generate());
+        bytes += shaders.back().size();
+    }
+
+    // Keeps the reflections from being optimized away.
+    size_t declarations = 0;
+    const double uncached = usPerShader(count, [&]() {
+        for (const auto &shader: shaders)
+            declarations += WgslReflect(shader).ast.size();
+    });
+    const double uncachedDeclarations = usPerShader(count, [&]() {
+        for (const auto &shader: shaders)
+            declarations += WgslReflect(shader, WgslParser::ParseMode::Declarations).ast.size();
+    });
+
+    std::filesystem::remove_all(directory);
+    ReflectionCache cache(directory.string());
+    const double cold = usPerShader(count, [&]() {
+        for (const auto &shader: shaders)
+            declarations += cache.reflect(shader).ast.size();
+    });
+    const double warm = usPerShader(count, [&]() {
+        for (const auto &shader: shaders)
+            declarations += cache.reflect(shader).ast.size();
+    });
+    size_t imageBytes = 0;
+    const double lookup = usPerShader(count, [&]() {
+        for (const auto &shader: shaders)
+            imageBytes += MappedFile(cache.path(shader)).view().size();
+    });
+    size_t missingBodies = 0;
+    for (const auto &shader: shaders) {
+        auto reflect = cache.reflect(shader);
+        for (auto function: reflect.functions)
+            missingBodies += reflect.getBody(function) == nullptr;
+    }
+    std::filesystem::remove_all(directory);
+
+    std::printf("%zu shaders, %zu bytes, %zu bytes cached, %zu declarations\n", count, bytes, imageBytes,
+                declarations);
+    std::printf("  uncached    : %9.2f us/shader\n", uncached);
+    std::printf("  declarations: %9.2f us/shader\n", uncachedDeclarations);
+    std::printf("  cold cache  : %9.2f us/shader\n", cold);
+    std::printf("  warm cache  : %9.2f us/shader\n", warm);
+    std::printf("  file lookup : %9.2f us/shader\n", lookup);
+    std::printf("hits %zu, misses %zu, missing bodies %zu\n", cache.hits(), cache.misses(), missingBodies);
+    return cache.hits() == 2 * count && cache.misses() == count && missingBodies == 0 ? 0 : 1;
+}
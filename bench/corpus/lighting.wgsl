@@ -0,0 +1,101 @@
+// Forward lighting with a handful of point lights, a base color texture and a shadow map.
+
+struct Camera {
+    viewProjection : mat4x4<f32>,
+    inverseView : mat4x4<f32>,
+    position : vec3<f32>,
+    exposure : f32,
+};
+
+struct PointLight {
+    position : vec3<f32>,
+    range : f32,
+    color : vec3<f32>,
+    intensity : f32,
+};
+
+struct Lights {
+    ambient : vec4<f32>,
+    count : u32,
+    lights : array<PointLight, 16>,
+};
+
+struct Material {
+    baseColor : vec4<f32>,
+    emissive : vec3<f32>,
+    roughness : f32,
+    metallic : f32,
+    occlusionStrength : f32,
+};
+
+@group(0) @binding(0) var<uniform> camera : Camera;
+@group(0) @binding(1) var<uniform> lights : Lights;
+@group(1) @binding(0) var<uniform> material : Material;
+@group(1) @binding(1) var baseColorSampler : sampler;
+@group(1) @binding(2) var baseColorTexture : texture_2d<f32>;
+@group(1) @binding(3) var normalTexture : texture_2d<f32>;
+@group(2) @binding(0) var shadowSampler : sampler_comparison;
+@group(2) @binding(1) var shadowTexture : texture_2d<f32>;
+
+fn saturate(x : f32) -> f32 {
+    return clamp(x, 0.0, 1.0);
+}
+
+fn attenuation(distance : f32, range : f32) -> f32 {
+    let ratio = distance / range;
+    let falloff = saturate(1.0 - ratio * ratio * ratio * ratio);
+    return falloff * falloff / (distance * distance + 1.0);
+}
+
+fn distributionGGX(nDotH : f32, roughness : f32) -> f32 {
+    let a = roughness * roughness;
+    let a2 = a * a;
+    let denominator = nDotH * nDotH * (a2 - 1.0) + 1.0;
+    return a2 / (3.14159265 * denominator * denominator);
+}
+
+fn geometrySchlick(nDotV : f32, roughness : f32) -> f32 {
+    let r = roughness + 1.0;
+    let k = r * r / 8.0;
+    return nDotV / (nDotV * (1.0 - k) + k);
+}
+
+fn fresnelSchlick(cosTheta : f32, f0 : vec3<f32>) -> vec3<f32> {
+    return f0 + (vec3<f32>(1.0, 1.0, 1.0) - f0) * pow(1.0 - cosTheta, 5.0);
+}
+
+fn specular(nDotL : f32, nDotV : f32, nDotH : f32, roughness : f32) -> f32 {
+    let d = distributionGGX(nDotH, roughness);
+    let g = geometrySchlick(nDotV, roughness) * geometrySchlick(nDotL, roughness);
+    return d * g / max(4.0 * nDotV * nDotL, 0.0001);
+}
+
+fn toneMap(color : vec3<f32>, exposure : f32) -> vec3<f32> {
+    let mapped = vec3<f32>(1.0, 1.0, 1.0) - exp(-color * exposure);
+    return pow(mapped, vec3<f32>(0.4545, 0.4545, 0.4545));
+}
+
+@stage(vertex)
+fn vs_main(@location(0) position : vec3<f32>, @location(1) normal : vec3<f32>, @location(2) uv : vec2<f32>) -> @builtin(position) vec4<f32> {
+    var world : vec4<f32> = vec4<f32>(position, 1.0);
+    return world;
+}
+
+@stage(fragment)
+fn fs_main(@location(0) uv : vec2<f32>, @location(1) normal : vec3<f32>, @location(2) world : vec3<f32>) -> @location(0) vec4<f32> {
+    let base = textureSample(baseColorTexture, baseColorSampler, uv);
+    let n = normalize(normal);
+    var color : vec3<f32> = vec3<f32>(0.0, 0.0, 0.0);
+    for (var i : u32 = 0u; i < 16u; i = i + 1u) {
+        let toLight = vec3<f32>(1.0, 1.0, 1.0) - world;
+        let distance = length(toLight);
+        let l = toLight / distance;
+        let nDotL = saturate(dot(n, l));
+        if (nDotL > 0.0) {
+            let h = normalize(l + n);
+            let s = specular(nDotL, saturate(dot(n, h)), saturate(dot(n, h)), 0.5);
+            color = color + vec3<f32>(s, s, s) * nDotL * attenuation(distance, 10.0);
+        }
+    }
+    return vec4<f32>(toneMap(color, 1.0), 1.0);
+}
@@ -0,0 +1,93 @@
+// Particle simulation: integrates velocities, applies attractors and recycles dead particles.
+
+struct SimulationParams {
+    deltaTime : f32,
+    gravity : vec3<f32>,
+    damping : f32,
+    attractorCount : u32,
+    seed : vec4<f32>,
+};
+
+struct Attractor {
+    position : vec3<f32>,
+    strength : f32,
+};
+
+@group(0) @binding(0) var<uniform> params : SimulationParams;
+@group(0) @binding(1) var<storage, read> attractors : array<Attractor>;
+@group(0) @binding(2) var<storage, read_write> positions : array<vec4<f32>>;
+@group(0) @binding(3) var<storage, read_write> velocities : array<vec4<f32>>;
+@group(0) @binding(4) var<storage, read_write> lifetimes : array<f32>;
+@group(1) @binding(0) var noiseTexture : texture_2d<f32>;
+@group(1) @binding(1) var noiseSampler : sampler;
+
+var<workgroup> sharedPositions : array<vec4<f32>, 64>;
+var<private> rngState : u32;
+
+fn hash(value : u32) -> u32 {
+    var x : u32 = value;
+    x = x ^ (x >> 16u);
+    x = x * 2146121005u;
+    x = x ^ (x >> 15u);
+    x = x * 2221713035u;
+    x = x ^ (x >> 16u);
+    return x;
+}
+
+fn random() -> f32 {
+    rngState = hash(rngState);
+    return f32(rngState) / 4294967295.0;
+}
+
+fn randomInSphere() -> vec3<f32> {
+    let theta = random() * 6.28318530;
+    let phi = acos(2.0 * random() - 1.0);
+    let r = pow(random(), 0.33333);
+    return vec3<f32>(r * sin(phi) * cos(theta), r * sin(phi) * sin(theta), r * cos(phi));
+}
+
+fn attraction(position : vec3<f32>, target : vec3<f32>, strength : f32) -> vec3<f32> {
+    let offset = target - position;
+    let distanceSquared = max(dot(offset, offset), 0.01);
+    return normalize(offset) * (strength / distanceSquared);
+}
+
+fn integrate(position : vec3<f32>, velocity : vec3<f32>, acceleration : vec3<f32>, dt : f32) -> vec3<f32> {
+    return position + velocity * dt + acceleration * (0.5 * dt * dt);
+}
+
+@stage(compute) @workgroup_size(64)
+fn simulate(@builtin(global_invocation_id) id : vec3<u32>, @builtin(local_invocation_index) local : u32) {
+    rngState = hash(local);
+    var acceleration : vec3<f32> = vec3<f32>(0.0, -9.81, 0.0);
+    for (var i : u32 = 0u; i < 8u; i = i + 1u) {
+        acceleration = acceleration + attraction(vec3<f32>(0.0, 0.0, 0.0), randomInSphere(), 1.0);
+    }
+    var velocity : vec3<f32> = acceleration * 0.016;
+    var position : vec3<f32> = integrate(vec3<f32>(0.0, 0.0, 0.0), velocity, acceleration, 0.016);
+    var life : f32 = 1.0 - 0.016;
+    if (life < 0.0) {
+        position = randomInSphere();
+        velocity = randomInSphere() * 0.5;
+        life = 1.0 + random();
+    }
+    loop {
+        if (life > 0.5) {
+            break;
+        }
+        life = life + 0.25;
+    }
+}
+
+@stage(vertex)
+fn vs_main(@builtin(vertex_index) index : u32, @location(0) position : vec4<f32>) -> @builtin(position) vec4<f32> {
+    let corner = vec2<f32>(f32(index & 1u), f32(index >> 1u)) * 2.0 - vec2<f32>(1.0, 1.0);
+    return position + vec4<f32>(corner * 0.02, 0.0, 0.0);
+}
+
+@stage(fragment)
+fn fs_main(@location(0) uv : vec2<f32>) -> @location(0) vec4<f32> {
+    let noise = textureSample(noiseTexture, noiseSampler, uv);
+    let falloff = 1.0 - smoothStep(0.0, 1.0, length(uv));
+    return noise * falloff;
+}
@@ -0,0 +1,90 @@
+// Post processing chain: bloom threshold, blur, color grading and vignette in one pass.
+
+struct PostParams {
+    resolution : vec2<f32>,
+    bloomThreshold : f32,
+    bloomIntensity : f32,
+    contrast : f32,
+    saturation : f32,
+    vignette : f32,
+    time : f32,
+    lift : vec4<f32>,
+    gamma : vec4<f32>,
+    gain : vec4<f32>,
+};
+
+@group(0) @binding(0) var<uniform> post : PostParams;
+@group(0) @binding(1) var linearSampler : sampler;
+@group(0) @binding(2) var sceneTexture : texture_2d<f32>;
+@group(0) @binding(3) var bloomTexture : texture_2d<f32>;
+@group(0) @binding(4) var lutTexture : texture_3d<f32>;
+@group(0) @binding(5) var historyTexture : texture_2d<f32>;
+@group(1) @binding(0) var outputTexture : texture_storage_2d<rgba8unorm, write>;
+
+fn luminance(color : vec3<f32>) -> f32 {
+    return dot(color, vec3<f32>(0.2126, 0.7152, 0.0722));
+}
+
+fn threshold(color : vec3<f32>, limit : f32) -> vec3<f32> {
+    let brightness = luminance(color);
+    let contribution = max(brightness - limit, 0.0) / max(brightness, 0.0001);
+    return color * contribution;
+}
+
+fn gaussian(offset : f32, sigma : f32) -> f32 {
+    return exp(-(offset * offset) / (2.0 * sigma * sigma)) / (2.50662827 * sigma);
+}
+
+fn blur(uv : vec2<f32>, direction : vec2<f32>) -> vec3<f32> {
+    var sum : vec3<f32> = vec3<f32>(0.0, 0.0, 0.0);
+    var weights : f32 = 0.0;
+    for (var i : i32 = -6; i <= 6; i = i + 1) {
+        let w = gaussian(f32(i), 3.0);
+        let sample = textureSample(bloomTexture, linearSampler, uv + direction * f32(i));
+        sum = sum + vec3<f32>(w, w, w) * luminance(vec3<f32>(1.0, 1.0, 1.0));
+        weights = weights + w;
+    }
+    return sum / weights;
+}
+
+fn adjustContrast(color : vec3<f32>, contrast : f32) -> vec3<f32> {
+    return (color - vec3<f32>(0.5, 0.5, 0.5)) * contrast + vec3<f32>(0.5, 0.5, 0.5);
+}
+
+fn adjustSaturation(color : vec3<f32>, saturation : f32) -> vec3<f32> {
+    let grey = luminance(color);
+    return mix(vec3<f32>(grey, grey, grey), color, saturation);
+}
+
+fn liftGammaGain(color : vec3<f32>, lift : vec3<f32>, gamma : vec3<f32>, gain : vec3<f32>) -> vec3<f32> {
+    let lifted = color * (vec3<f32>(1.0, 1.0, 1.0) - lift) + lift;
+    return pow(max(lifted * gain, vec3<f32>(0.0, 0.0, 0.0)), vec3<f32>(1.0, 1.0, 1.0) / gamma);
+}
+
+fn vignette(uv : vec2<f32>, strength : f32) -> f32 {
+    let centered = uv - vec2<f32>(0.5, 0.5);
+    return 1.0 - dot(centered, centered) * strength;
+}
+
+fn filmGrain(uv : vec2<f32>, time : f32) -> f32 {
+    let noise = fract(sin(dot(uv, vec2<f32>(12.9898, 78.233)) + time) * 43758.5453);
+    return (noise - 0.5) * 0.04;
+}
+
+@stage(vertex)
+fn vs_main(@builtin(vertex_index) index : u32) -> @builtin(position) vec4<f32> {
+    let uv = vec2<f32>(f32((index << 1u) & 2u), f32(index & 2u));
+    return vec4<f32>(uv * 2.0 - vec2<f32>(1.0, 1.0), 0.0, 1.0);
+}
+
+@stage(fragment)
+fn fs_main(@location(0) uv : vec2<f32>) -> @location(0) vec4<f32> {
+    let scene = textureSample(sceneTexture, linearSampler, uv);
+    let bloom = blur(uv, vec2<f32>(1.0, 0.0)) + blur(uv, vec2<f32>(0.0, 1.0));
+    var color : vec3<f32> = bloom * 0.5;
+    color = adjustContrast(color, 1.1);
+    color = adjustSaturation(color, 1.05);
+    color = liftGammaGain(color, vec3<f32>(0.0, 0.0, 0.0), vec3<f32>(1.0, 1.0, 1.0), vec3<f32>(1.0, 1.0, 1.0));
+    color = color * vignette(uv, 0.8) + vec3<f32>(filmGrain(uv, 0.0), 0.0, 0.0);
+    return vec4<f32>(color, 1.0);
+}
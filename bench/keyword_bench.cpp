@@ -0,0 +1,65 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+// Compares keyword classification through the perfect hash (Token::findKeyword) with the
+// scanner's previous path, a substr of the source looked up in the Token::Keywords() map, for a
+// mix of keywords and plain identifiers.
+
+#include "../wgsl_scanner.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+template<typename F>
+double nsPerLookup(const std::vector<std::string_view> &lexemes, size_t rounds, F &&classify) {
+    size_t hits = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (const auto &lexeme: lexemes)
+            hits += classify(lexeme);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    // Keeps the loop from being optimized away.
+    if (hits == 0)
+        std::printf("no keywords found\n");
+    const auto ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / double(rounds * lexemes.size());
+}
+}
+
+int main() {
+    std::vector<std::string> words = Token::WgslKeywords();
+    words.insert(words.end(), Token::WgslReserved().begin(), Token::WgslReserved().end());
+    for (const char *ident: {"position", "uv", "color", "normal", "i", "lightDir", "output", "modelViewProjection",
+                             "textureSample", "dot", "tex_coord0", "vec5", "float3", "fragColor"}) {
+        words.emplace_back(ident);
+    }
+
+    // Lexemes are views of one source buffer, the way the scanner sees them.
+    std::string source;
+    for (const auto &word: words)
+        source += word + " ";
+    std::vector<std::string_view> lexemes;
+    size_t offset = 0;
+    for (const auto &word: words) {
+        lexemes.push_back(std::string_view(source).substr(offset, word.size()));
+        offset += word.size() + 1;
+    }
+
+    const size_t rounds = 20000;
+    const double map = nsPerLookup(lexemes, rounds, [](std::string_view lexeme) {
+        return Token::Keywords().find(std::string(lexeme)) != Token::Keywords().end();
+    });
+    const double perfect = nsPerLookup(lexemes, rounds, [](std::string_view lexeme) {
+        return Token::findKeyword(lexeme) != nullptr;
+    });
+
+    std::printf("keyword lookup, %zu lexemes x %zu rounds\n", lexemes.size(), rounds);
+    std::printf("  Token::Keywords map : %6.2f ns/lookup\n", map);
+    std::printf("  Token::findKeyword  : %6.2f ns/lookup\n", perfect);
+    return 0;
+}
@@ -0,0 +1,121 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+// Compares looking up the structs of a module with thousands of them through the indexes of
+// WgslReflect with the previous path, a scan of WgslReflect::structs, both by name and by the
+// type of every struct member, the way a layout computation resolves nested structs. Also times
+// the layouts of the uniform buffers, computed on the first request and memoized after.
+//
+//   wgsl_lookup_bench [--structs <count>]
+
+#include "../wgsl_reflect.h"
+#include "shader_generator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+template<typename F>
+double nsPerLookup(size_t lookups, size_t rounds, F &&lookup) {
+    size_t hits = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        hits += lookup();
+    const auto end = std::chrono::steady_clock::now();
+    // Keeps the loop from being optimized away.
+    if (hits == 0)
+        std::printf("no structs found\n");
+    const auto ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / double(rounds * lookups);
+}
+
+StructNode *scanStructs(const WgslReflect &reflect, const Symbol *name) {
+    for (const auto s: reflect.structs) {
+        if (s->symbol() == name)
+            return s;
+    }
+    return nullptr;
+}
+}
+
+int main(int argc, char **argv) {
+    ShaderGenerator::Options options;
+    options.structs = 4000;
+    options.members = 8;
+    options.nestedMembers = 4;
+    options.bindings = 64;
+    options.functions = 4;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--structs") == 0 && i + 1 < argc) {
+            options.structs = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--structs <count>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    WgslReflect reflect(ShaderGenerator(options).generate());
+    std::vector<std::string> names;
+    std::vector<TypeNode *> memberTypes;
+    for (const auto s: reflect.structs) {
+        names.emplace_back(s->name());
+        for (const auto member: s->members) {
+            auto type = member->as<MemberNode>()->type;
+            if (reflect.getStruct(type))
+                memberTypes.push_back(type);
+        }
+    }
+
+    // The scans are quadratic, so they get fewer rounds.
+    const double scanByName = nsPerLookup(names.size(), 1, [&]() {
+        size_t hits = 0;
+        for (const auto &name: names)
+            hits += scanStructs(reflect, reflect.symbols.find(name)) != nullptr;
+        return hits;
+    });
+    const double indexByName = nsPerLookup(names.size(), 100, [&]() {
+        size_t hits = 0;
+        for (const auto &name: names)
+            hits += reflect.getStruct(name) != nullptr;
+        return hits;
+    });
+    const double scanByType = nsPerLookup(memberTypes.size(), 1, [&]() {
+        size_t hits = 0;
+        for (const auto type: memberTypes)
+            hits += scanStructs(reflect, type->symbol()) != nullptr;
+        return hits;
+    });
+    const double layoutFirst = nsPerLookup(reflect.uniforms.size(), 1, [&]() {
+        size_t hits = 0;
+        for (const auto var: reflect.uniforms)
+            hits += reflect.getUniformBufferInfo(var) != nullptr;
+        return hits;
+    });
+    const double layoutMemoized = nsPerLookup(reflect.uniforms.size(), 100, [&]() {
+        size_t hits = 0;
+        for (const auto var: reflect.uniforms)
+            hits += reflect.getUniformBufferInfo(var) != nullptr;
+        return hits;
+    });
+    const double indexByType = nsPerLookup(memberTypes.size(), 100, [&]() {
+        size_t hits = 0;
+        for (const auto type: memberTypes)
+            hits += reflect.getStruct(type) != nullptr;
+        return hits;
+    });
+
+    std::printf("struct lookup, %zu structs, %zu nested members\n", names.size(), memberTypes.size());
+    std::printf("  by name, scan  : %9.2f ns/lookup\n", scanByName);
+    std::printf("  by name, index : %9.2f ns/lookup\n", indexByName);
+    std::printf("  by type, scan  : %9.2f ns/lookup\n", scanByType);
+    std::printf("  by type, index : %9.2f ns/lookup\n", indexByType);
+    std::printf("uniform buffer layout, %zu uniforms\n", reflect.uniforms.size());
+    std::printf("  first          : %9.2f ns/lookup\n", layoutFirst);
+    std::printf("  memoized       : %9.2f ns/lookup\n", layoutMemoized);
+    return 0;
+}
@@ -0,0 +1,208 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "shader_generator.h"
+
+#include <algorithm>
+
+ShaderGenerator::ShaderGenerator(const Options &options) :
+        _options(options),
+        _state(options.seed) {
+}
+
+std::string ShaderGenerator::generate() {
+    _out.clear();
+    _state = _options.seed;
+    for (size_t i = 0; i < _options.structs; ++i)
+        _struct(i);
+    for (size_t i = 0; i < _options.bindings; ++i)
+        _binding(i);
+    for (size_t i = 0; i < _options.functions; ++i)
+        _function(i);
+    _entryPoints();
+    return _out;
+}
+
+void ShaderGenerator::_struct(size_t index) {
+    _out += "struct S" + std::to_string(index) + " {\n";
+    for (size_t i = 0; i < _options.members; ++i) {
+        _out += "    m" + std::to_string(i) + " : ";
+        if (i < _options.nestedMembers && index > 0)
+            _out += "S" + std::to_string(_pick(index));
+        else
+            _type();
+        _out += ",\n";
+    }
+    _out += "};\n\n";
+}
+
+void ShaderGenerator::_binding(size_t index) {
+    // Past 32 groups of 16 the groups get fuller instead, as reflection takes 32 groups at most.
+    const size_t perGroup = std::max<size_t>(16, (_options.bindings + 31) / 32);
+    _out += "@group(" + std::to_string(index / perGroup) + ") @binding(" + std::to_string(index % perGroup) + ") ";
+    const auto name = std::to_string(index);
+    switch (index % 4) {
+        case 0:
+            if (_options.structs > 0) {
+                _out += "var<uniform> uniforms" + name + " : S" + std::to_string(_pick(_options.structs)) + ";\n";
+            } else {
+                _out += "var<uniform> uniforms" + name + " : vec4<f32>;\n";
+            }
+            break;
+        case 1:
+            _out += "var<storage, read_write> buffer" + name + " : array<vec4<f32>>;\n";
+            break;
+        case 2:
+            _out += "var texture" + name + " : texture_2d<f32>;\n";
+            break;
+        default:
+            _out += "var sampler" + name + " : sampler;\n";
+            break;
+    }
+}
+
+void ShaderGenerator::_function(size_t index) {
+    _functionIndex = index;
+    _lets = 0;
+    _vars = 0;
+    _out += "\nfn func" + std::to_string(index) + "(a : f32, b : f32) -> f32 {\n";
+    for (size_t i = 0; i < _options.statements; ++i)
+        _statement();
+    _out += "    return ";
+    _expression(_options.expressionDepth);
+    _out += ";\n}\n";
+}
+
+void ShaderGenerator::_entryPoints() {
+    const bool sampled = _options.bindings >= 4;
+    const std::string call = _options.functions > 0 ? "func0(1.0, 2.0)" : "1.0";
+
+    _out += "\n@stage(vertex)\n"
+            "fn vs_main(@builtin(vertex_index) index : u32) -> @builtin(position) vec4<f32> {\n"
+            "    return vec4<f32>(" + call + ", 0.0, 0.0, 1.0);\n"
+            "}\n";
+
+    _out += "\n@stage(fragment)\n"
+            "fn fs_main(@location(0) uv : vec2<f32>) -> @location(0) vec4<f32> {\n";
+    if (sampled)
+        _out += "    let color = textureSample(texture2, sampler3, uv);\n";
+    else
+        _out += "    let color = vec4<f32>(uv, 0.0, 1.0);\n";
+    _out += "    return color * " + call + ";\n"
+            "}\n";
+
+    _out += "\n@stage(compute) @workgroup_size(64)\n"
+            "fn cs_main(@builtin(global_invocation_id) id : vec3<u32>) {\n"
+            "    var total : f32 = 0.0;\n"
+            "    for (var i : i32 = 0; i < 64; i = i + 1) {\n"
+            "        total = total + f32(i) * " + call + ";\n"
+            "    }\n"
+            "}\n";
+}
+
+void ShaderGenerator::_statement() {
+    const size_t kind = _vars > 0 ? _pick(4) : _pick(2);
+    switch (kind) {
+        case 0:
+            _out += "    let l" + std::to_string(_lets) + " = ";
+            _expression(_options.expressionDepth);
+            _out += ";\n";
+            _lets++;
+            break;
+        case 1:
+            _out += "    var v" + std::to_string(_vars) + " : f32 = ";
+            _expression(_options.expressionDepth);
+            _out += ";\n";
+            _vars++;
+            break;
+        case 2: {
+            const auto target = "v" + std::to_string(_pick(_vars));
+            _out += "    if (";
+            _expression(1);
+            _out += " > ";
+            _expression(1);
+            _out += ") {\n        " + target + " = ";
+            _expression(_options.expressionDepth);
+            _out += ";\n    } else {\n        " + target + " = ";
+            _expression(_options.expressionDepth);
+            _out += ";\n    }\n";
+            break;
+        }
+        default: {
+            const auto target = "v" + std::to_string(_pick(_vars));
+            _out += "    for (var i : i32 = 0; i < " + std::to_string(4 + _pick(60)) + "; i = i + 1) {\n"
+                    "        " + target + " = " + target + " + f32(i) * ";
+            _expression(_options.expressionDepth);
+            _out += ";\n    }\n";
+            break;
+        }
+    }
+}
+
+void ShaderGenerator::_expression(size_t depth) {
+    if (depth == 0) {
+        const size_t names = 2 + _lets + _vars;
+        const size_t pick = _pick(names + 1);
+        if (pick == names) {
+            _out += std::to_string(_pick(100)) + "." + std::to_string(_pick(10));
+        } else if (pick < 2) {
+            _out += pick == 0 ? "a" : "b";
+        } else if (pick < 2 + _lets) {
+            _out += "l" + std::to_string(pick - 2);
+        } else {
+            _out += "v" + std::to_string(pick - 2 - _lets);
+        }
+        return;
+    }
+
+    static const char *const operators[] = {" + ", " - ", " * ", " / "};
+    switch (_pick(8)) {
+        case 0:
+            _out += "max(";
+            _expression(depth - 1);
+            _out += ", ";
+            _expression(depth - 1);
+            _out += ")";
+            break;
+        case 1:
+            _out += "sqrt(";
+            _expression(depth - 1);
+            _out += ")";
+            break;
+        case 2:
+            // Calls only go to earlier functions, so there is no recursion.
+            if (_functionIndex > 0) {
+                _out += "func" + std::to_string(_pick(_functionIndex)) + "(";
+                _expression(depth - 1);
+                _out += ", ";
+                _expression(depth - 1);
+                _out += ")";
+                break;
+            }
+            [[fallthrough]];
+        default:
+            _out += "(";
+            _expression(depth - 1);
+            _out += operators[_pick(4)];
+            _expression(depth - 1);
+            _out += ")";
+            break;
+    }
+}
+
+void ShaderGenerator::_type() {
+    static const char *const types[] = {"f32", "i32", "u32", "vec2<f32>", "vec3<f32>", "vec4<f32>", "mat4x4<f32>",
+                                        "array<vec4<f32>, 4>"};
+    _out += types[_pick(sizeof(types) / sizeof(types[0]))];
+}
+
+uint64_t ShaderGenerator::_next() {
+    // splitmix64, which unlike the std distributions gives the same sequence on every platform.
+    uint64_t z = (_state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,65 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_SHADER_GENERATOR_H
+#define WGSL_INTROSPECTOR_SHADER_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+// Generates synthetic WGSL shaders of any size for the benchmarks. The output only depends on
+// the options, seed included, so a benchmark run can be reproduced anywhere.
+class ShaderGenerator {
+public:
+    struct Options {
+        uint64_t seed = 1;
+        size_t structs = 16;
+        size_t members = 8;
+        // The members of each struct, first ones first, whose type is an earlier struct.
+        size_t nestedMembers = 0;
+        // Uniform and storage buffers, textures and samplers, 16 to a group, or more when there
+        // would be over 32 groups.
+        size_t bindings = 16;
+        size_t functions = 16;
+        size_t statements = 12;
+        size_t expressionDepth = 4;
+    };
+
+    explicit ShaderGenerator(const Options &options);
+
+    std::string generate();
+
+private:
+    void _struct(size_t index);
+
+    void _binding(size_t index);
+
+    void _function(size_t index);
+
+    void _entryPoints();
+
+    void _statement();
+
+    void _expression(size_t depth);
+
+    void _type();
+
+    uint64_t _next();
+
+    size_t _pick(size_t count) {
+        return static_cast<size_t>(_next() % count);
+    }
+
+    Options _options;
+    uint64_t _state;
+    std::string _out;
+    // The let and var locals declared so far in the function being generated.
+    size_t _lets = 0;
+    size_t _vars = 0;
+    size_t _functionIndex = 0;
+};
+
+#endif //WGSL_INTROSPECTOR_SHADER_GENERATOR_H
@@ -0,0 +1,126 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+// Reflects different shaders on 1, 2, 4, ... threads at once, with no locking around the
+// reflection, and prints the reflections/s for each thread count with its speedup over one
+// thread. Every result is checked against a reflection of the same shader on one thread, so a
+// run also stresses the scanner and parser tables that all threads share.
+//
+//   wgsl_stress_bench [--threads <max>] [--min-time <seconds>]
+
+#include "../wgsl_reflect.h"
+#include "shader_generator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+// What a reflection found, to compare reflections of the same shader.
+struct Summary {
+    size_t ast = 0;
+    size_t structs = 0;
+    size_t uniforms = 0;
+    size_t textures = 0;
+    size_t samplers = 0;
+    size_t functions = 0;
+
+    bool operator==(const Summary &other) const {
+        return ast == other.ast && structs == other.structs && uniforms == other.uniforms &&
+               textures == other.textures && samplers == other.samplers && functions == other.functions;
+    }
+};
+
+Summary summarize(const std::string &source) {
+    WgslReflect reflect(source);
+    return {reflect.ast.size(), reflect.structs.size(), reflect.uniforms.size(), reflect.textures.size(),
+            reflect.samplers.size(), reflect.functions.size()};
+}
+
+// Shaders of a few hundred lines, each different, so that threads don't all work on the same
+// input.
+std::vector<std::string> makeShaders(size_t count) {
+    std::vector<std::string> shaders;
+    for (size_t i = 0; i < count; ++i) {
+        ShaderGenerator::Options options;
+        options.seed = i + 1;
+        options.structs = 8 + i % 8;
+        options.bindings = 8 + i % 16;
+        options.functions = 8 + i % 8;
+        shaders.push_back(ShaderGenerator(options).generate());
+    }
+    return shaders;
+}
+
+// Runs threads threads for minTime, each reflecting shaders in turn from its own starting
+// point, and returns the reflections/s. Sets failed if any result differs from expected.
+double reflectionsPerSecond(const std::vector<std::string> &shaders, const std::vector<Summary> &expected,
+                            size_t threads, double minTime, std::atomic<bool> &failed) {
+    using Clock = std::chrono::steady_clock;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> reflections{0};
+    std::vector<std::thread> workers;
+    const auto start = Clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            size_t done = 0;
+            for (size_t i = t; !stop.load(std::memory_order_relaxed); i = (i + 1) % shaders.size()) {
+                if (!(summarize(shaders[i]) == expected[i]))
+                    failed = true;
+                done++;
+            }
+            reflections += done;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(minTime));
+    stop = true;
+    for (auto &worker: workers)
+        worker.join();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return double(reflections) / elapsed;
+}
+}
+
+int main(int argc, char **argv) {
+    size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    double minTime = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            maxThreads = std::max(std::atoi(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTime = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--threads <max>] [--min-time <seconds>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const auto shaders = makeShaders(std::max<size_t>(maxThreads * 2, 8));
+    std::vector<Summary> expected;
+    for (const auto &shader: shaders)
+        expected.push_back(summarize(shader));
+
+    std::atomic<bool> failed{false};
+    std::printf("threads,reflections_per_sec,speedup\n");
+    double single = 0;
+    for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        const double rate = reflectionsPerSecond(shaders, expected, threads, minTime, failed);
+        if (threads == 1)
+            single = rate;
+        std::printf("%zu,%.0f,%.2f\n", threads, rate, rate / single);
+        if (threads == maxThreads)
+            break;
+    }
+
+    if (failed) {
+        std::fprintf(stderr, "A reflection on several threads differed from the one on a single thread\n");
+        return 1;
+    }
+    return 0;
+}
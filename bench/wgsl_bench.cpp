@@ -0,0 +1,451 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+// Measures scanning (tokens/s and bytes/s), parsing of a scanned token stream (ASTs/s and
+// bytes/s, and bytes/s of a declarations-only parse and of a parse on a thread pool), loading
+// the ASTs from a serialized image instead (its size, and its ratio to the size of the source,
+// and source bytes/s, to compare with scanning plus parsing) and end-to-end reflection latency
+// (full, and declarations-only), over the shaders in bench/corpus and a set of synthetic
+// shaders. Prints one CSV row, or one JSON object, per shader. Before measuring a shader it
+// checks that loading the image of a full and of a declarations parse gives the same ASTs as
+// the parse; a shader that doesn't is an error.
+//
+//   wgsl_bench [--corpus <dir>] [--min-time <seconds>] [--json]
+
+#include "../wgsl_ast_serializer.h"
+#include "../wgsl_reflect.h"
+#include "shader_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef WGSL_BENCH_CORPUS
+#define WGSL_BENCH_CORPUS "bench/corpus"
+#endif
+
+namespace {
+struct Input {
+    std::string name;
+    std::string source;
+};
+
+struct Result {
+    std::string name;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t asts = 0;
+    double scanSeconds = 0;
+    double parseSeconds = 0;
+    double parseDeclarationsSeconds = 0;
+    double parseParallelSeconds = 0;
+    size_t imageBytes = 0;
+    double loadSeconds = 0;
+    double reflectSeconds = 0;
+    double reflectDeclarationsSeconds = 0;
+};
+
+// Runs f until minTime has passed, at least three times, and returns the seconds per run.
+template<typename F>
+double secondsPerRun(double minTime, F &&f) {
+    using Clock = std::chrono::steady_clock;
+    size_t runs = 0;
+    const auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        f();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (runs < 3 || elapsed < minTime);
+    return elapsed / double(runs);
+}
+
+std::vector<Input> loadCorpus(const std::filesystem::path &directory) {
+    std::vector<Input> inputs;
+    for (const auto &entry: std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() != ".wgsl")
+            continue;
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::stringstream source;
+        source << file.rdbuf();
+        inputs.push_back({entry.path().stem().string(), source.str()});
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const Input &a, const Input &b) {
+        return a.name < b.name;
+    });
+    return inputs;
+}
+
+std::vector<Input> syntheticInputs() {
+    std::vector<std::pair<std::string, ShaderGenerator::Options>> shapes;
+    shapes.emplace_back("synthetic_small", ShaderGenerator::Options{});
+
+    ShaderGenerator::Options structs;
+    structs.structs = 2000;
+    structs.members = 16;
+    structs.functions = 4;
+    shapes.emplace_back("synthetic_structs", structs);
+
+    ShaderGenerator::Options bindings;
+    bindings.structs = 64;
+    bindings.bindings = 1024;
+    bindings.functions = 4;
+    shapes.emplace_back("synthetic_bindings", bindings);
+
+    ShaderGenerator::Options deep;
+    deep.functions = 32;
+    deep.statements = 8;
+    deep.expressionDepth = 9;
+    shapes.emplace_back("synthetic_deep", deep);
+
+    ShaderGenerator::Options large;
+    large.structs = 500;
+    large.bindings = 256;
+    large.functions = 400;
+    shapes.emplace_back("synthetic_large", large);
+
+    std::vector<Input> inputs;
+    for (const auto &[name, options]: shapes)
+        inputs.push_back({name, ShaderGenerator(options).generate()});
+    return inputs;
+}
+
+// Whether two ASTs of source, parsed or loaded into different symbol tables, are the same: node
+// for node, field for field, with names and idents compared by their text.
+class SameAst {
+public:
+    explicit SameAst(std::string_view source) : _source(source) {
+    }
+
+    bool operator()(const AST *a, const AST *b) const {
+        if (!a || !b)
+            return a == b;
+        if (a->kind() != b->kind() || a->name() != b->name())
+            return false;
+        if (auto expr = a->as<ExprNode>()) {
+            if (!(*this)(expr->postfix, b->as<ExprNode>()->postfix))
+                return false;
+        }
+
+        switch (a->kind()) {
+            case NodeKind::Alias:
+                return (*this)(a->as<AliasNode>()->alias, b->as<AliasNode>()->alias);
+            case NodeKind::Struct: {
+                auto x = a->as<StructNode>(), y = b->as<StructNode>();
+                return _list(x->attributes, y->attributes) && _list(x->members, y->members);
+            }
+            case NodeKind::Member: {
+                auto x = a->as<MemberNode>(), y = b->as<MemberNode>();
+                return _list(x->attributes, y->attributes) && (*this)(x->type, y->type);
+            }
+            case NodeKind::Var: {
+                auto x = a->as<VarNode>(), y = b->as<VarNode>();
+                return _list(x->attributes, y->attributes) && x->storage == y->storage && x->access == y->access &&
+                       (*this)(x->type, y->type) && (*this)(x->value, y->value) && x->group() == y->group() &&
+                       x->binding() == y->binding();
+            }
+            case NodeKind::Let: {
+                auto x = a->as<LetNode>(), y = b->as<LetNode>();
+                return _list(x->attributes, y->attributes) && (*this)(x->type, y->type) &&
+                       (*this)(x->value, y->value);
+            }
+            case NodeKind::Function: {
+                auto x = a->as<FunctionNode>(), y = b->as<FunctionNode>();
+                return _list(x->attributes, y->attributes) && _list(x->args, y->args) &&
+                       (*this)(x->returnType, y->returnType) && (*this)(x->body, y->body) &&
+                       x->bodyOffset == y->bodyOffset && x->bodyLength == y->bodyLength &&
+                       x->bodyLine == y->bodyLine;
+            }
+            case NodeKind::Arg: {
+                auto x = a->as<ArgNode>(), y = b->as<ArgNode>();
+                return _list(x->attributes, y->attributes) && (*this)(x->type, y->type);
+            }
+            case NodeKind::Attribute: {
+                auto x = a->as<AttributeNode>(), y = b->as<AttributeNode>();
+                return _strings(x->values, y->values) && _tokens(x->tokens, y->tokens);
+            }
+            case NodeKind::Type:
+            case NodeKind::Array:
+            case NodeKind::Sampler: {
+                auto x = a->as<TypeNode>(), y = b->as<TypeNode>();
+                return _list(x->attributes, y->attributes) && (*this)(x->format, y->format) &&
+                       (*this)(x->decl, y->decl) && x->access == y->access && x->count == y->count &&
+                       x->countName == y->countName;
+            }
+            case NodeKind::Create: {
+                auto x = a->as<CreateNode>(), y = b->as<CreateNode>();
+                return (*this)(x->type, y->type) && _list(x->args, y->args);
+            }
+            case NodeKind::Block:
+                return _list(a->as<BlockNode>()->statements, b->as<BlockNode>()->statements);
+            case NodeKind::VarStatement: {
+                auto x = a->as<VarStatementNode>(), y = b->as<VarStatementNode>();
+                return (*this)(x->var, y->var) && (*this)(x->value, y->value);
+            }
+            case NodeKind::Assign: {
+                auto x = a->as<AssignNode>(), y = b->as<AssignNode>();
+                return (*this)(x->var, y->var) && (*this)(x->value, y->value);
+            }
+            case NodeKind::Call:
+                return _list(a->as<CallNode>()->args, b->as<CallNode>()->args);
+            case NodeKind::If:
+            case NodeKind::ElseIf: {
+                auto x = a->as<IfNode>(), y = b->as<IfNode>();
+                return (*this)(x->condition, y->condition) && (*this)(x->block, y->block) &&
+                       _list(x->elseif, y->elseif) && (*this)(x->elseBlock, y->elseBlock);
+            }
+            case NodeKind::Switch: {
+                auto x = a->as<SwitchNode>(), y = b->as<SwitchNode>();
+                return (*this)(x->condition, y->condition) && _list(x->body, y->body);
+            }
+            case NodeKind::Case:
+            case NodeKind::Default: {
+                auto x = a->as<CaseNode>(), y = b->as<CaseNode>();
+                return _strings(x->selectors, y->selectors) && _list(x->body, y->body);
+            }
+            case NodeKind::Loop: {
+                auto x = a->as<LoopNode>(), y = b->as<LoopNode>();
+                return _list(x->statements, y->statements) && (*this)(x->continuing, y->continuing);
+            }
+            case NodeKind::For: {
+                auto x = a->as<ForNode>(), y = b->as<ForNode>();
+                return (*this)(x->init, y->init) && (*this)(x->condition, y->condition) &&
+                       (*this)(x->increment, y->increment) && (*this)(x->body, y->body);
+            }
+            case NodeKind::While: {
+                auto x = a->as<WhileNode>(), y = b->as<WhileNode>();
+                return (*this)(x->condition, y->condition) && (*this)(x->block, y->block);
+            }
+            case NodeKind::Return:
+                return (*this)(a->as<ReturnNode>()->value, b->as<ReturnNode>()->value);
+            case NodeKind::CompareOp:
+            case NodeKind::BinaryOp: {
+                auto x = a->as<BinaryOpNode>(), y = b->as<BinaryOpNode>();
+                return (*this)(x->left, y->left) && (*this)(x->right, y->right);
+            }
+            case NodeKind::UnaryOp:
+                return (*this)(a->as<UnaryOpNode>()->right, b->as<UnaryOpNode>()->right);
+            case NodeKind::CallExpr:
+                return _list(a->as<CallExprNode>()->args, b->as<CallExprNode>()->args);
+            case NodeKind::BitcastExpr:
+            case NodeKind::TypecastExpr: {
+                auto x = a->as<CastExprNode>(), y = b->as<CastExprNode>();
+                return (*this)(x->type, y->type) && (*this)(x->value, y->value) && _list(x->args, y->args);
+            }
+            case NodeKind::GroupingExpr:
+                return (*this)(a->as<GroupingExprNode>()->expr, b->as<GroupingExprNode>()->expr);
+            default:
+                return true;
+        }
+    }
+
+    bool operator()(const std::vector<AST *> &a, const std::vector<AST *> &b) const {
+        return _list({a.data(), a.size()}, {b.data(), b.size()});
+    }
+
+private:
+    bool _list(ArenaSpan<AST *> a, ArenaSpan<AST *> b) const {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (!(*this)(a[i], b[i]))
+                return false;
+        }
+        return true;
+    }
+
+    static bool _strings(ArenaSpan<std::string_view> a, ArenaSpan<std::string_view> b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    // Tokens are the same span of the source; an ident's value is its symbol id, which differs
+    // from table to table, so only whether it has one is compared.
+    bool _tokens(TokenSpan a, TokenSpan b) const {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const auto &x = a[i], &y = b[i];
+            if (x.kind() != y.kind() || x.line() != y.line() ||
+                x.lexeme(_source).data() != y.lexeme(_source).data() ||
+                x.lexeme(_source).size() != y.lexeme(_source).size())
+                return false;
+            if (x.kind() == TokenKind::Ident ? (x.symbolId() != 0) != (y.symbolId() != 0)
+                                             : x.uintValue() != y.uintValue())
+                return false;
+        }
+        return true;
+    }
+
+    std::string_view _source;
+};
+
+// Checks that the ASTs loaded from the image of a parse of input are the same as the parse, in
+// both parse modes.
+void checkRoundTrip(const Input &input) {
+    for (auto mode: {WgslParser::ParseMode::Full, WgslParser::ParseMode::Declarations}) {
+        SymbolTable symbols;
+        AstArena arena;
+        WgslParser parser(symbols, arena, mode);
+        const auto parsed = parser.parse(input.source);
+        const auto image = AstSerializer::write(input.source, parsed);
+        SymbolTable loadedSymbols;
+        AstArena loadedArena;
+        const auto loaded = AstSerializer::read(image, loadedSymbols, loadedArena);
+        if (!SameAst(input.source)(parsed, loaded)) {
+            throw std::runtime_error(std::string("the ASTs loaded from the image of a ") +
+                                     (mode == WgslParser::ParseMode::Full ? "full" : "declarations") +
+                                     " parse differ from the parse");
+        }
+    }
+}
+
+Result measure(const Input &input, double minTime, ThreadPool &pool) {
+    checkRoundTrip(input);
+
+    Result result;
+    result.name = input.name;
+    result.bytes = input.source.size();
+
+    std::vector<Token> tokens;
+    result.scanSeconds = secondsPerRun(minTime, [&]() {
+        tokens = WgslScanner(input.source).scanTokens();
+    });
+    result.tokens = tokens.size();
+
+    // A service parsing one module after another reuses its arena, so the arena is reset
+    // instead of recreated.
+    AstArena arena;
+    result.parseSeconds = secondsPerRun(minTime, [&]() {
+        arena.reset();
+        SymbolTable symbols;
+        WgslParser parser(symbols, arena);
+        result.asts = parser.parse(input.source, tokens).size();
+    });
+    result.parseDeclarationsSeconds = secondsPerRun(minTime, [&]() {
+        arena.reset();
+        SymbolTable symbols;
+        WgslParser parser(symbols, arena, WgslParser::ParseMode::Declarations);
+        parser.parse(input.source, tokens);
+    });
+    result.parseParallelSeconds = secondsPerRun(minTime, [&]() {
+        arena.reset();
+        SymbolTable symbols;
+        WgslParser parser(symbols, arena);
+        parser.parse(input.source, tokens, pool);
+    });
+
+    std::string image;
+    {
+        arena.reset();
+        SymbolTable symbols;
+        WgslParser parser(symbols, arena);
+        image = AstSerializer::write(input.source, parser.parse(input.source, tokens));
+    }
+    result.imageBytes = image.size();
+    result.loadSeconds = secondsPerRun(minTime, [&]() {
+        arena.reset();
+        SymbolTable symbols;
+        AstSerializer::read(image, symbols, arena);
+    });
+
+    result.reflectSeconds = secondsPerRun(minTime, [&]() {
+        WgslReflect reflect(input.source);
+    });
+    result.reflectDeclarationsSeconds = secondsPerRun(minTime, [&]() {
+        WgslReflect reflect(input.source, WgslParser::ParseMode::Declarations);
+    });
+    return result;
+}
+
+void printCsvHeader() {
+    std::printf("shader,bytes,tokens,asts,scan_tokens_per_sec,scan_bytes_per_sec,"
+                "parse_asts_per_sec,parse_bytes_per_sec,parse_decls_bytes_per_sec,parse_parallel_bytes_per_sec,"
+                "image_bytes,image_ratio,load_bytes_per_sec,reflect_us,reflect_decls_us\n");
+}
+
+void printCsv(const Result &r) {
+    std::printf("%s,%zu,%zu,%zu,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%zu,%.2f,%.0f,%.2f,%.2f\n",
+                r.name.c_str(), r.bytes, r.tokens, r.asts,
+                double(r.tokens) / r.scanSeconds, double(r.bytes) / r.scanSeconds,
+                double(r.asts) / r.parseSeconds, double(r.bytes) / r.parseSeconds,
+                double(r.bytes) / r.parseDeclarationsSeconds, double(r.bytes) / r.parseParallelSeconds,
+                r.imageBytes, double(r.imageBytes) / double(r.bytes), double(r.bytes) / r.loadSeconds,
+                r.reflectSeconds * 1e6, r.reflectDeclarationsSeconds * 1e6);
+}
+
+void printJson(const Result &r, bool last) {
+    std::printf("  {\"shader\": \"%s\", \"bytes\": %zu, \"tokens\": %zu, \"asts\": %zu, "
+                "\"scan_tokens_per_sec\": %.0f, \"scan_bytes_per_sec\": %.0f, "
+                "\"parse_asts_per_sec\": %.0f, \"parse_bytes_per_sec\": %.0f, "
+                "\"parse_decls_bytes_per_sec\": %.0f, \"parse_parallel_bytes_per_sec\": %.0f, "
+                "\"image_bytes\": %zu, \"image_ratio\": %.2f, \"load_bytes_per_sec\": %.0f, "
+                "\"reflect_us\": %.2f, \"reflect_decls_us\": %.2f}%s\n",
+                r.name.c_str(), r.bytes, r.tokens, r.asts,
+                double(r.tokens) / r.scanSeconds, double(r.bytes) / r.scanSeconds,
+                double(r.asts) / r.parseSeconds, double(r.bytes) / r.parseSeconds,
+                double(r.bytes) / r.parseDeclarationsSeconds, double(r.bytes) / r.parseParallelSeconds,
+                r.imageBytes, double(r.imageBytes) / double(r.bytes), double(r.bytes) / r.loadSeconds,
+                r.reflectSeconds * 1e6, r.reflectDeclarationsSeconds * 1e6, last ? "" : ",");
+}
+}
+
+int main(int argc, char **argv) {
+    std::string corpus = WGSL_BENCH_CORPUS;
+    double minTime = 0.25;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+            corpus = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTime = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--corpus <dir>] [--min-time <seconds>] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Input> inputs;
+    try {
+        inputs = loadCorpus(corpus);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "Can't read the corpus in %s: %s\n", corpus.c_str(), e.what());
+        return 1;
+    }
+    auto synthetic = syntheticInputs();
+    inputs.insert(inputs.end(), synthetic.begin(), synthetic.end());
+
+    ThreadPool pool;
+    std::vector<Result> results;
+    int status = 0;
+    for (const auto &input: inputs) {
+        try {
+            results.push_back(measure(input, minTime, pool));
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "%s: %s\n", input.name.c_str(), e.what());
+            status = 1;
+        }
+    }
+
+    if (json) {
+        std::printf("[\n");
+        for (size_t i = 0; i < results.size(); ++i)
+            printJson(results[i], i + 1 == results.size());
+        std::printf("]\n");
+    } else {
+        printCsvHeader();
+        for (const auto &result: results)
+            printCsv(result);
+    }
+    return status;
+}
@@ -0,0 +1,200 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_ast.h"
+
+namespace {
+#define WGSL_NODE_TYPE(kind, type) type,
+constexpr std::string_view kNodeTypes[] = {WGSL_NODE_KINDS(WGSL_NODE_TYPE)};
+#undef WGSL_NODE_TYPE
+}
+
+std::string_view AST::type() const {
+    return kNodeTypes[static_cast<size_t>(_kind)];
+}
+
+ArenaSpan<AST *> AST::nodeAttributes() const {
+    switch (_kind) {
+        case NodeKind::Struct:
+            return as<StructNode>()->attributes;
+        case NodeKind::Member:
+            return as<MemberNode>()->attributes;
+        case NodeKind::Var:
+            return as<VarNode>()->attributes;
+        case NodeKind::Let:
+            return as<LetNode>()->attributes;
+        case NodeKind::Function:
+            return as<FunctionNode>()->attributes;
+        case NodeKind::Arg:
+            return as<ArgNode>()->attributes;
+        case NodeKind::Type:
+        case NodeKind::Array:
+        case NodeKind::Sampler:
+            return as<TypeNode>()->attributes;
+        default:
+            return {};
+    }
+}
+
+AST *AST::child(std::string_view name) const {
+    if (auto expr = as<ExprNode>(); expr && name == "postfix")
+        return expr->postfix;
+
+    switch (_kind) {
+        case NodeKind::Alias:
+            return name == "alias" ? as<AliasNode>()->alias : nullptr;
+        case NodeKind::Member:
+            return name == "type" ? as<MemberNode>()->type : nullptr;
+        case NodeKind::Var: {
+            auto node = as<VarNode>();
+            if (name == "type") return node->type;
+            if (name == "value") return node->value;
+            return nullptr;
+        }
+        case NodeKind::Let: {
+            auto node = as<LetNode>();
+            if (name == "type") return node->type;
+            if (name == "value") return node->value;
+            return nullptr;
+        }
+        case NodeKind::Function: {
+            auto node = as<FunctionNode>();
+            if (name == "return") return node->returnType;
+            if (name == "body") return node->body;
+            return nullptr;
+        }
+        case NodeKind::Arg:
+            return name == "type" ? as<ArgNode>()->type : nullptr;
+        case NodeKind::Type:
+        case NodeKind::Array:
+        case NodeKind::Sampler: {
+            auto node = as<TypeNode>();
+            if (name == "format") return node->format;
+            if (name == "decl") return node->decl;
+            return nullptr;
+        }
+        case NodeKind::Create:
+            return name == "type" ? as<CreateNode>()->type : nullptr;
+        case NodeKind::VarStatement: {
+            auto node = as<VarStatementNode>();
+            if (name == "var") return node->var;
+            if (name == "value") return node->value;
+            return nullptr;
+        }
+        case NodeKind::Assign: {
+            auto node = as<AssignNode>();
+            if (name == "var") return node->var;
+            if (name == "value") return node->value;
+            return nullptr;
+        }
+        case NodeKind::If:
+        case NodeKind::ElseIf: {
+            auto node = as<IfNode>();
+            if (name == "condition") return node->condition;
+            if (name == "block") return node->block;
+            if (name == "else") return node->elseBlock;
+            return nullptr;
+        }
+        case NodeKind::Switch:
+            return name == "condition" ? as<SwitchNode>()->condition : nullptr;
+        case NodeKind::Loop:
+            return name == "continuing" ? as<LoopNode>()->continuing : nullptr;
+        case NodeKind::For: {
+            auto node = as<ForNode>();
+            if (name == "init") return node->init;
+            if (name == "condition") return node->condition;
+            if (name == "increment") return node->increment;
+            if (name == "body") return node->body;
+            return nullptr;
+        }
+        case NodeKind::While: {
+            auto node = as<WhileNode>();
+            if (name == "condition") return node->condition;
+            if (name == "block") return node->block;
+            return nullptr;
+        }
+        case NodeKind::Return:
+            return name == "value" ? as<ReturnNode>()->value : nullptr;
+        case NodeKind::CompareOp:
+        case NodeKind::BinaryOp: {
+            auto node = as<BinaryOpNode>();
+            if (name == "left") return node->left;
+            if (name == "right") return node->right;
+            return nullptr;
+        }
+        case NodeKind::UnaryOp:
+            return name == "right" ? as<UnaryOpNode>()->right : nullptr;
+        case NodeKind::BitcastExpr:
+        case NodeKind::TypecastExpr: {
+            auto node = as<CastExprNode>();
+            if (name == "type") return node->type;
+            if (name == "value") return node->value;
+            return nullptr;
+        }
+        case NodeKind::GroupingExpr:
+            // Parenthesized expressions used to call their expression "contents", and the
+            // optionally parenthesized conditions "expr".
+            return name == "expr" || name == "contents" ? as<GroupingExprNode>()->expr : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+ArenaSpan<AST *> AST::childVec(std::string_view name) const {
+    if (name == "attributes")
+        return nodeAttributes();
+
+    switch (_kind) {
+        case NodeKind::Struct:
+            return name == "members" ? as<StructNode>()->members : ArenaSpan<AST *>();
+        case NodeKind::Function:
+            return name == "args" ? as<FunctionNode>()->args : ArenaSpan<AST *>();
+        case NodeKind::Create:
+            return name == "args" ? as<CreateNode>()->args : ArenaSpan<AST *>();
+        case NodeKind::Block:
+            return name.empty() ? as<BlockNode>()->statements : ArenaSpan<AST *>();
+        case NodeKind::Call:
+            return name == "args" ? as<CallNode>()->args : ArenaSpan<AST *>();
+        case NodeKind::If:
+            return name == "elseif" ? as<IfNode>()->elseif : ArenaSpan<AST *>();
+        case NodeKind::Switch:
+            return name == "body" ? as<SwitchNode>()->body : ArenaSpan<AST *>();
+        case NodeKind::Case:
+        case NodeKind::Default:
+            return name == "body" ? as<CaseNode>()->body : ArenaSpan<AST *>();
+        case NodeKind::Loop:
+            return name == "statements" ? as<LoopNode>()->statements : ArenaSpan<AST *>();
+        case NodeKind::CallExpr:
+            return name == "args" ? as<CallExprNode>()->args : ArenaSpan<AST *>();
+        case NodeKind::TypecastExpr:
+            return name == "args" ? as<CastExprNode>()->args : ArenaSpan<AST *>();
+        default:
+            return {};
+    }
+}
+
+ArenaSpan<std::string_view> AST::nameVec(std::string_view name) const {
+    switch (_kind) {
+        case NodeKind::Var: {
+            auto node = as<VarNode>();
+            if (name == "storage") return {&node->storage, 1};
+            if (name == "access") return {&node->access, 1};
+            return {};
+        }
+        case NodeKind::Case:
+            return name == "selector" ? as<CaseNode>()->selectors : ArenaSpan<std::string_view>();
+        case NodeKind::Attribute:
+            return name == "value" ? as<AttributeNode>()->values : ArenaSpan<std::string_view>();
+        default:
+            return {};
+    }
+}
+
+TokenSpan AST::tokenVec(std::string_view name) const {
+    if (auto node = as<AttributeNode>(); node && name == "value")
+        return node->tokens;
+    return {};
+}
@@ -0,0 +1,505 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_AST_H
+#define WGSL_INTROSPECTOR_WGSL_AST_H
+
+#include <cstdint>
+#include <string_view>
+#include "wgsl_ast_arena.h"
+#include "wgsl_scanner.h"
+#include "wgsl_symbol_table.h"
+
+// The node kinds as X(Kind, "type") pairs, where type is the name AST::type() reports. The
+// expression kinds come last, so they can be told apart with one compare.
+#define WGSL_NODE_KINDS(X) \
+        X(Enable, "enable") \
+        X(Alias, "alias") \
+        X(Struct, "struct") \
+        X(Member, "member") \
+        X(Var, "var") \
+        X(Let, "let") \
+        X(Function, "function") \
+        X(Arg, "arg") \
+        X(Attribute, "attribute") \
+        X(Type, "type") \
+        X(Array, "array") \
+        X(Sampler, "sampler") \
+        X(Create, "create") \
+        X(Block, "") \
+        X(VarStatement, "var") \
+        X(Assign, "assign") \
+        X(Call, "call") \
+        X(If, "if") \
+        X(ElseIf, "elseif") \
+        X(Switch, "switch") \
+        X(Case, "case") \
+        X(Default, "default") \
+        X(Loop, "loop") \
+        X(For, "for") \
+        X(While, "while") \
+        X(Return, "return") \
+        X(Break, "break") \
+        X(Continue, "continue") \
+        X(Discard, "discard") \
+        X(CompareOp, "compareOp") \
+        X(BinaryOp, "binaryOp") \
+        X(UnaryOp, "unaryOp") \
+        X(CallExpr, "call_expr") \
+        X(VariableExpr, "variable_expr") \
+        X(LiteralExpr, "literal_expr") \
+        X(BitcastExpr, "bitcast_expr") \
+        X(TypecastExpr, "typecast_expr") \
+        X(GroupingExpr, "grouping_expr")
+
+enum class NodeKind : uint8_t {
+#define WGSL_NODE_KIND(kind, type) kind,
+    WGSL_NODE_KINDS(WGSL_NODE_KIND)
+#undef WGSL_NODE_KIND
+};
+
+struct BlockNode;
+struct ExprNode;
+struct TypeNode;
+struct VarNode;
+
+//MARK: - AST
+// A node of the syntax tree. Every kind of node has a struct of its own below, with a fixed
+// field for each of its children, and as<T>() gets to it. Nodes live in the AstArena of
+// their parse, so they are all trivially destructible and never destroyed one by one.
+//
+// child, childVec, nameVec and tokenVec look the fields up by their old names, for code that
+// still walks the tree by name.
+class AST {
+public:
+    explicit AST(NodeKind kind) : _kind(kind) {
+    }
+
+    [[nodiscard]] NodeKind kind() const {
+        return _kind;
+    }
+
+    [[nodiscard]] std::string_view type() const;
+
+    void setName(const Symbol *name) {
+        _name = name;
+    }
+
+    [[nodiscard]] std::string_view name() const {
+        return _name ? _name->text : std::string_view();
+    }
+
+    // Names interned in the same table are the same when their symbols are.
+    [[nodiscard]] const Symbol *symbol() const {
+        return _name;
+    }
+
+    // The node as a T, or nullptr when it is of another kind.
+    template<typename T>
+    [[nodiscard]] T *as() {
+        return T::is(_kind) ? static_cast<T *>(this) : nullptr;
+    }
+
+    template<typename T>
+    [[nodiscard]] const T *as() const {
+        return T::is(_kind) ? static_cast<const T *>(this) : nullptr;
+    }
+
+    // The attributes of the kinds that have them, empty for the others.
+    [[nodiscard]] ArenaSpan<AST *> nodeAttributes() const;
+
+    [[nodiscard]] AST *child(std::string_view name) const;
+
+    [[nodiscard]] ArenaSpan<AST *> childVec(std::string_view name) const;
+
+    [[nodiscard]] ArenaSpan<std::string_view> nameVec(std::string_view name) const;
+
+    // The tokens behind nameVec, for their decoded literal values.
+    [[nodiscard]] TokenSpan tokenVec(std::string_view name) const;
+
+private:
+    NodeKind _kind;
+    const Symbol *_name = nullptr;
+};
+
+//MARK: - Declarations
+struct StructNode : AST {
+    StructNode() : AST(NodeKind::Struct) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Struct;
+    }
+
+    ArenaSpan<AST *> attributes;
+    ArenaSpan<AST *> members;
+};
+
+struct MemberNode : AST {
+    MemberNode() : AST(NodeKind::Member) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Member;
+    }
+
+    ArenaSpan<AST *> attributes;
+    TypeNode *type = nullptr;
+};
+
+struct VarNode : AST {
+    VarNode() : AST(NodeKind::Var) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Var;
+    }
+
+    uint32_t group() const {
+        return _group;
+    }
+
+    void setGroup(uint32_t value) {
+        _group = value;
+    }
+
+    uint32_t binding() const {
+        return _binding;
+    }
+
+    void setBinding(uint32_t value) {
+        _binding = value;
+    }
+
+    ArenaSpan<AST *> attributes;
+    // Empty when the var has no qualifier.
+    std::string_view storage;
+    std::string_view access;
+    TypeNode *type = nullptr;
+    AST *value = nullptr;
+
+private:
+    uint32_t _group = 0;
+    uint32_t _binding = 0;
+};
+
+struct LetNode : AST {
+    LetNode() : AST(NodeKind::Let) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Let;
+    }
+
+    ArenaSpan<AST *> attributes;
+    TypeNode *type = nullptr;
+    AST *value = nullptr;
+};
+
+struct AliasNode : AST {
+    AliasNode() : AST(NodeKind::Alias) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Alias;
+    }
+
+    TypeNode *alias = nullptr;
+};
+
+struct FunctionNode : AST {
+    FunctionNode() : AST(NodeKind::Function) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Function;
+    }
+
+    ArenaSpan<AST *> attributes;
+    ArenaSpan<AST *> args;
+    TypeNode *returnType = nullptr;
+    // Null when a declarations parse skipped the body; WgslParser::parseBody parses it then.
+    BlockNode *body = nullptr;
+    // The span of source from the '{' of the body to its '}', and the line of the '{'.
+    uint32_t bodyOffset = 0;
+    uint32_t bodyLength = 0;
+    uint32_t bodyLine = 0;
+};
+
+struct ArgNode : AST {
+    ArgNode() : AST(NodeKind::Arg) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Arg;
+    }
+
+    ArenaSpan<AST *> attributes;
+    TypeNode *type = nullptr;
+};
+
+struct AttributeNode : AST {
+    AttributeNode() : AST(NodeKind::Attribute) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Attribute;
+    }
+
+    ArenaSpan<std::string_view> values;
+    // The tokens of values, for their decoded literal values.
+    TokenSpan tokens;
+};
+
+// A type, array or sampler type. format is the template argument of a templated type, decl
+// the type a pointer points to.
+struct TypeNode : AST {
+    explicit TypeNode(NodeKind kind) : AST(kind) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Type || kind == NodeKind::Array || kind == NodeKind::Sampler;
+    }
+
+    ArenaSpan<AST *> attributes;
+    TypeNode *format = nullptr;
+    TypeNode *decl = nullptr;
+    // The access mode of a storage texture or pointer, empty when it has none.
+    std::string_view access;
+    // The element count of an array sized by a literal; 0 for a runtime-sized array, or one
+    // sized by a constant.
+    uint32_t count = 0;
+    // The name of the constant an array is sized by, empty when it has no count or a literal one.
+    std::string_view countName;
+};
+
+// A constant constructor expression, the initializer of a global var or let.
+struct CreateNode : AST {
+    CreateNode() : AST(NodeKind::Create) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Create;
+    }
+
+    TypeNode *type = nullptr;
+    ArenaSpan<AST *> args;
+};
+
+//MARK: - Statements
+struct BlockNode : AST {
+    BlockNode() : AST(NodeKind::Block) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Block;
+    }
+
+    ArenaSpan<AST *> statements;
+};
+
+struct VarStatementNode : AST {
+    VarStatementNode() : AST(NodeKind::VarStatement) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::VarStatement;
+    }
+
+    VarNode *var = nullptr;
+    ExprNode *value = nullptr;
+};
+
+struct AssignNode : AST {
+    AssignNode() : AST(NodeKind::Assign) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Assign;
+    }
+
+    ExprNode *var = nullptr;
+    ExprNode *value = nullptr;
+};
+
+struct CallNode : AST {
+    CallNode() : AST(NodeKind::Call) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Call;
+    }
+
+    ArenaSpan<AST *> args;
+};
+
+// An if, or one of its elseif branches.
+struct IfNode : AST {
+    explicit IfNode(NodeKind kind) : AST(kind) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::If || kind == NodeKind::ElseIf;
+    }
+
+    ExprNode *condition = nullptr;
+    BlockNode *block = nullptr;
+    // Only set on an if.
+    ArenaSpan<AST *> elseif;
+    BlockNode *elseBlock = nullptr;
+};
+
+struct SwitchNode : AST {
+    SwitchNode() : AST(NodeKind::Switch) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Switch;
+    }
+
+    ExprNode *condition = nullptr;
+    ArenaSpan<AST *> body;
+};
+
+// A case, or the default case, of a switch.
+struct CaseNode : AST {
+    explicit CaseNode(NodeKind kind) : AST(kind) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Case || kind == NodeKind::Default;
+    }
+
+    ArenaSpan<std::string_view> selectors;
+    ArenaSpan<AST *> body;
+};
+
+struct LoopNode : AST {
+    LoopNode() : AST(NodeKind::Loop) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Loop;
+    }
+
+    ArenaSpan<AST *> statements;
+    BlockNode *continuing = nullptr;
+};
+
+struct ForNode : AST {
+    ForNode() : AST(NodeKind::For) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::For;
+    }
+
+    AST *init = nullptr;
+    ExprNode *condition = nullptr;
+    AST *increment = nullptr;
+    BlockNode *body = nullptr;
+};
+
+struct WhileNode : AST {
+    WhileNode() : AST(NodeKind::While) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::While;
+    }
+
+    ExprNode *condition = nullptr;
+    BlockNode *block = nullptr;
+};
+
+struct ReturnNode : AST {
+    ReturnNode() : AST(NodeKind::Return) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::Return;
+    }
+
+    ExprNode *value = nullptr;
+};
+
+//MARK: - Expressions
+// Any expression. postfix is the index expression that follows it, if any. Variable and
+// literal expressions have nothing but their name.
+struct ExprNode : AST {
+    explicit ExprNode(NodeKind kind) : AST(kind) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind >= NodeKind::CompareOp;
+    }
+
+    ExprNode *postfix = nullptr;
+};
+
+// A binary or comparison operator, named by its operator token.
+struct BinaryOpNode : ExprNode {
+    explicit BinaryOpNode(NodeKind kind) : ExprNode(kind) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::BinaryOp || kind == NodeKind::CompareOp;
+    }
+
+    ExprNode *left = nullptr;
+    ExprNode *right = nullptr;
+};
+
+struct UnaryOpNode : ExprNode {
+    UnaryOpNode() : ExprNode(NodeKind::UnaryOp) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::UnaryOp;
+    }
+
+    ExprNode *right = nullptr;
+};
+
+struct CallExprNode : ExprNode {
+    CallExprNode() : ExprNode(NodeKind::CallExpr) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::CallExpr;
+    }
+
+    ArenaSpan<AST *> args;
+};
+
+// A bitcast or a type constructor call.
+struct CastExprNode : ExprNode {
+    explicit CastExprNode(NodeKind kind) : ExprNode(kind) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::BitcastExpr || kind == NodeKind::TypecastExpr;
+    }
+
+    TypeNode *type = nullptr;
+    // The operand of a bitcast.
+    ExprNode *value = nullptr;
+    // The arguments of a type constructor.
+    ArenaSpan<AST *> args;
+};
+
+struct GroupingExprNode : ExprNode {
+    GroupingExprNode() : ExprNode(NodeKind::GroupingExpr) {
+    }
+
+    static bool is(NodeKind kind) {
+        return kind == NodeKind::GroupingExpr;
+    }
+
+    ExprNode *expr = nullptr;
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_AST_H
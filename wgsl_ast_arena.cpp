@@ -0,0 +1,90 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_ast_arena.h"
+
+namespace {
+char *alignUp(char *pointer, size_t align) {
+    return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(pointer) + align - 1) & ~(align - 1));
+}
+}
+
+AstArena::AstArena(AstArena &&other) noexcept:
+        _blocks(std::move(other._blocks)),
+        _large(std::move(other._large)),
+        _largeUsed(std::exchange(other._largeUsed, 0)),
+        _block(std::exchange(other._block, 0)),
+        _next(std::exchange(other._next, nullptr)),
+        _end(std::exchange(other._end, nullptr)) {
+}
+
+AstArena &AstArena::operator=(AstArena &&other) noexcept {
+    if (this != &other) {
+        _blocks = std::move(other._blocks);
+        _large = std::move(other._large);
+        _largeUsed = std::exchange(other._largeUsed, 0);
+        _block = std::exchange(other._block, 0);
+        _next = std::exchange(other._next, nullptr);
+        _end = std::exchange(other._end, nullptr);
+    }
+    return *this;
+}
+
+std::string_view AstArena::copy(std::string_view text) {
+    if (text.empty())
+        return {};
+    auto data = static_cast<char *>(allocate(text.size(), 1));
+    std::memcpy(data, text.data(), text.size());
+    return {data, text.size()};
+}
+
+void AstArena::adopt(AstArena &&other) {
+    // The filled blocks of other go in before the block being filled, with the filled blocks of
+    // this arena.
+    const size_t filled = other._next ? other._block + 1 : 0;
+    const auto at = _blocks.begin() + static_cast<std::ptrdiff_t>(_block);
+    _blocks.insert(at, std::make_move_iterator(other._blocks.begin()),
+                   std::make_move_iterator(other._blocks.begin() + static_cast<std::ptrdiff_t>(filled)));
+    _block += filled;
+    _large.insert(_large.end(), std::make_move_iterator(other._large.begin()),
+                  std::make_move_iterator(other._large.end()));
+    _largeUsed += other._largeUsed;
+    other = AstArena();
+}
+
+void AstArena::reset() {
+    _large.clear();
+    _largeUsed = 0;
+    _block = 0;
+    _next = _blocks.empty() ? nullptr : _blocks[0].get();
+    _end = _blocks.empty() ? nullptr : _blocks[0].get() + kBlockSize;
+}
+
+size_t AstArena::bytesUsed() const {
+    const size_t filling = _next ? size_t(_next - _blocks[_block].get()) : 0;
+    return _block * kBlockSize + filling + _largeUsed;
+}
+
+void *AstArena::_allocateSlow(size_t size, size_t align) {
+    // new only guarantees fundamental alignment, so padding for align is added to what is
+    // allocated, and skipped at the start of it.
+    if (size + align - 1 > kBlockSize / 4) {
+        _large.emplace_back(new char[size + align - 1]);
+        _largeUsed += size + align - 1;
+        return alignUp(_large.back().get(), align);
+    }
+
+    if (_next)
+        _block++;
+    if (_block == _blocks.size())
+        _blocks.emplace_back(new char[kBlockSize]);
+    _next = _blocks[_block].get();
+    _end = _next + kBlockSize;
+
+    auto data = alignUp(_next, align);
+    _next = data + size;
+    return data;
+}
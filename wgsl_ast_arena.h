@@ -0,0 +1,140 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_AST_ARENA_H
+#define WGSL_INTROSPECTOR_WGSL_AST_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//MARK: - ArenaSpan
+// A read-only view of an array allocated in an AstArena.
+template<typename T>
+class ArenaSpan {
+public:
+    ArenaSpan() = default;
+
+    ArenaSpan(const T *data, size_t size) : _data(data), _size(size) {
+    }
+
+    [[nodiscard]] const T &operator[](size_t index) const {
+        return _data[index];
+    }
+
+    [[nodiscard]] const T *data() const {
+        return _data;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return _size;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _size == 0;
+    }
+
+    [[nodiscard]] const T *begin() const {
+        return _data;
+    }
+
+    [[nodiscard]] const T *end() const {
+        return _data + _size;
+    }
+
+private:
+    const T *_data = nullptr;
+    size_t _size = 0;
+};
+
+//MARK: - AstArena
+// A bump allocator for the nodes of a parse and everything they point to. Only trivially
+// destructible objects go in the arena, so nothing is destroyed one by one: resetting the
+// arena, or destroying it, frees a whole module at once. Reset keeps the blocks for the next
+// parse, so an arena reused across parses stops allocating once it is big enough. Not thread
+// safe.
+class AstArena {
+public:
+    AstArena() = default;
+
+    AstArena(const AstArena &) = delete;
+
+    AstArena &operator=(const AstArena &) = delete;
+
+    AstArena(AstArena &&other) noexcept;
+
+    AstArena &operator=(AstArena &&other) noexcept;
+
+    void *allocate(size_t size, size_t align);
+
+    template<typename T, typename... Args>
+    T *make(Args &&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    ArenaSpan<T> copy(const T *data, size_t size) {
+        static_assert(std::is_trivially_copyable_v<T>, "arena arrays are copied bytewise");
+        if (size == 0)
+            return {};
+        auto copy = static_cast<T *>(allocate(sizeof(T) * size, alignof(T)));
+        std::memcpy(copy, data, sizeof(T) * size);
+        return {copy, size};
+    }
+
+    template<typename T>
+    ArenaSpan<T> copy(const std::vector<T> &values) {
+        return copy(values.data(), values.size());
+    }
+
+    std::string_view copy(std::string_view text);
+
+    // Takes over what was allocated in other, which then is empty, so it lives as long as this
+    // arena. The blocks of other are reused after the next reset.
+    void adopt(AstArena &&other);
+
+    // Frees everything allocated so far, keeping the blocks for reuse.
+    void reset();
+
+    // The bytes used since the last reset, counting the unused ends of filled blocks.
+    [[nodiscard]] size_t bytesUsed() const;
+
+private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    void *_allocateSlow(size_t size, size_t align);
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    // Allocations too big for a block get their own, which are freed on reset.
+    std::vector<std::unique_ptr<char[]>> _large;
+    size_t _largeUsed = 0;
+    // The block being filled, and the free range in it.
+    size_t _block = 0;
+    char *_next = nullptr;
+    char *_end = nullptr;
+};
+
+inline void *AstArena::allocate(size_t size, size_t align) {
+    // The padding is checked against the free range before it is added, as an aligned pointer
+    // can be past the end of the block, where the free range would wrap around.
+    const size_t padding = (0 - reinterpret_cast<uintptr_t>(_next)) & (align - 1);
+    const size_t free = _end - _next;
+    if (_next && padding <= free && size <= free - padding) {
+        auto data = _next + padding;
+        _next = data + size;
+        return data;
+    }
+    return _allocateSlow(size, align);
+}
+
+#endif //WGSL_INTROSPECTOR_WGSL_AST_ARENA_H
@@ -0,0 +1,758 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_ast_serializer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+constexpr char kMagic[8] = {'W', 'G', 'S', 'L', 'A', 'S', 'T', '\0'};
+
+// The header is in the byte order of the machine that wrote it; on one of the other order the
+// version doesn't match. The sections after it are bytes.
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t rootCount;
+    uint64_t sourceHash;
+    uint32_t stringCount;
+    uint32_t stringSize;
+    uint32_t nodeSize;
+    uint32_t sourceSize;
+};
+
+static_assert(sizeof(Header) == 40, "the header is part of the image format");
+
+constexpr size_t kNodeKindCount = static_cast<size_t>(NodeKind::GroupingExpr) + 1;
+
+// Nodes are read recursively, so an image nested deeper than any parse could be is rejected
+// before it runs out of stack.
+constexpr uint32_t kMaxDepth = 4096;
+}
+
+//MARK: - Writer
+class AstSerializer::Writer {
+public:
+    explicit Writer(std::string_view source) : _source(source) {
+    }
+
+    std::string write(const std::vector<AST *> &ast) {
+        for (auto node: ast)
+            _node(node);
+
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = AstSerializer::kVersion;
+        header.rootCount = static_cast<uint32_t>(ast.size());
+        header.sourceHash = AstSerializer::hash(_source);
+        header.stringCount = static_cast<uint32_t>(_stringIndex.size());
+        header.stringSize = static_cast<uint32_t>(_strings.size());
+        header.nodeSize = static_cast<uint32_t>(_nodes.size());
+        header.sourceSize = static_cast<uint32_t>(_source.size());
+
+        std::string image;
+        image.reserve(sizeof(Header) + _strings.size() + _nodes.size());
+        image.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        image += _strings;
+        image += _nodes;
+        return image;
+    }
+
+private:
+    // Appends value in LEB128: 7 bits a byte, low bits first, the top bit set on all but the last.
+    static void _uint(std::string &out, uint32_t value) {
+        while (value >= 0x80) {
+            out += char(value | 0x80);
+            value >>= 7;
+        }
+        out += char(value);
+    }
+
+    void _uint(uint32_t value) {
+        _uint(_nodes, value);
+    }
+
+    // Writes node and its children in preorder: its kind + 1, 0 for no node, its name, the
+    // postfix of an expression, then the fields of its kind.
+    void _node(const AST *node) {
+        if (!node) {
+            _uint(0);
+            return;
+        }
+        _uint(static_cast<uint32_t>(node->kind()) + 1);
+        _string(node->symbol() ? node->name() : std::string_view());
+        if (auto expr = node->as<ExprNode>())
+            _node(expr->postfix);
+
+        switch (node->kind()) {
+            case NodeKind::Alias:
+                _node(node->as<AliasNode>()->alias);
+                break;
+            case NodeKind::Struct: {
+                auto n = node->as<StructNode>();
+                _list(n->attributes);
+                _list(n->members);
+                break;
+            }
+            case NodeKind::Member: {
+                auto n = node->as<MemberNode>();
+                _list(n->attributes);
+                _node(n->type);
+                break;
+            }
+            case NodeKind::Var: {
+                auto n = node->as<VarNode>();
+                _list(n->attributes);
+                _string(n->storage);
+                _string(n->access);
+                _node(n->type);
+                _node(n->value);
+                _uint(n->group());
+                _uint(n->binding());
+                break;
+            }
+            case NodeKind::Let: {
+                auto n = node->as<LetNode>();
+                _list(n->attributes);
+                _node(n->type);
+                _node(n->value);
+                break;
+            }
+            case NodeKind::Function: {
+                auto n = node->as<FunctionNode>();
+                _list(n->attributes);
+                _list(n->args);
+                _node(n->returnType);
+                _node(n->body);
+                _uint(n->bodyOffset);
+                _uint(n->bodyLength);
+                _uint(n->bodyLine);
+                break;
+            }
+            case NodeKind::Arg: {
+                auto n = node->as<ArgNode>();
+                _list(n->attributes);
+                _node(n->type);
+                break;
+            }
+            case NodeKind::Attribute: {
+                auto n = node->as<AttributeNode>();
+                _stringList(n->values);
+                _tokenList(n->tokens);
+                break;
+            }
+            case NodeKind::Type:
+            case NodeKind::Array:
+            case NodeKind::Sampler: {
+                auto n = node->as<TypeNode>();
+                _list(n->attributes);
+                _node(n->format);
+                _node(n->decl);
+                _string(n->access);
+                _uint(n->count);
+                _string(n->countName);
+                break;
+            }
+            case NodeKind::Create: {
+                auto n = node->as<CreateNode>();
+                _node(n->type);
+                _list(n->args);
+                break;
+            }
+            case NodeKind::Block:
+                _list(node->as<BlockNode>()->statements);
+                break;
+            case NodeKind::VarStatement: {
+                auto n = node->as<VarStatementNode>();
+                _node(n->var);
+                _node(n->value);
+                break;
+            }
+            case NodeKind::Assign: {
+                auto n = node->as<AssignNode>();
+                _node(n->var);
+                _node(n->value);
+                break;
+            }
+            case NodeKind::Call:
+                _list(node->as<CallNode>()->args);
+                break;
+            case NodeKind::If:
+            case NodeKind::ElseIf: {
+                auto n = node->as<IfNode>();
+                _node(n->condition);
+                _node(n->block);
+                _list(n->elseif);
+                _node(n->elseBlock);
+                break;
+            }
+            case NodeKind::Switch: {
+                auto n = node->as<SwitchNode>();
+                _node(n->condition);
+                _list(n->body);
+                break;
+            }
+            case NodeKind::Case:
+            case NodeKind::Default: {
+                auto n = node->as<CaseNode>();
+                _stringList(n->selectors);
+                _list(n->body);
+                break;
+            }
+            case NodeKind::Loop: {
+                auto n = node->as<LoopNode>();
+                _list(n->statements);
+                _node(n->continuing);
+                break;
+            }
+            case NodeKind::For: {
+                auto n = node->as<ForNode>();
+                _node(n->init);
+                _node(n->condition);
+                _node(n->increment);
+                _node(n->body);
+                break;
+            }
+            case NodeKind::While: {
+                auto n = node->as<WhileNode>();
+                _node(n->condition);
+                _node(n->block);
+                break;
+            }
+            case NodeKind::Return:
+                _node(node->as<ReturnNode>()->value);
+                break;
+            case NodeKind::CompareOp:
+            case NodeKind::BinaryOp: {
+                auto n = node->as<BinaryOpNode>();
+                _node(n->left);
+                _node(n->right);
+                break;
+            }
+            case NodeKind::UnaryOp:
+                _node(node->as<UnaryOpNode>()->right);
+                break;
+            case NodeKind::CallExpr:
+                _list(node->as<CallExprNode>()->args);
+                break;
+            case NodeKind::BitcastExpr:
+            case NodeKind::TypecastExpr: {
+                auto n = node->as<CastExprNode>();
+                _node(n->type);
+                _node(n->value);
+                _list(n->args);
+                break;
+            }
+            case NodeKind::GroupingExpr:
+                _node(node->as<GroupingExprNode>()->expr);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void _list(ArenaSpan<AST *> nodes) {
+        _uint(static_cast<uint32_t>(nodes.size()));
+        for (auto node: nodes)
+            _node(node);
+    }
+
+    void _stringList(ArenaSpan<std::string_view> strings) {
+        _uint(static_cast<uint32_t>(strings.size()));
+        for (auto string: strings)
+            _string(string);
+    }
+
+    void _tokenList(TokenSpan tokens) {
+        _uint(static_cast<uint32_t>(tokens.size()));
+        for (const auto &token: tokens) {
+            _uint(token._kind);
+            _uint(token._offset);
+            _uint(token._length);
+            _uint(token._line);
+            // The symbol id of an ident is only good in the table of its parse, so the image
+            // keeps its string instead.
+            if (token.kind() == TokenKind::Ident && token.symbolId() != 0)
+                _string(token.lexeme(_source));
+            else
+                _uint(token._value.u);
+        }
+    }
+
+    // Writes the index + 1 of text among the strings, 0 for an empty one, adding it the first
+    // time.
+    void _string(std::string_view text) {
+        if (text.empty()) {
+            _uint(0);
+            return;
+        }
+        auto [it, added] = _stringIndex.try_emplace(text, static_cast<uint32_t>(_stringIndex.size() + 1));
+        if (added) {
+            _uint(_strings, static_cast<uint32_t>(text.size()));
+            _strings += text;
+        }
+        _uint(it->second);
+    }
+
+    std::string_view _source;
+    // The length and text of every distinct string.
+    std::string _strings;
+    std::string _nodes;
+    std::unordered_map<std::string_view, uint32_t> _stringIndex;
+};
+
+//MARK: - Reader
+class AstSerializer::Reader {
+public:
+    Reader(std::string_view image, SymbolTable &symbols, AstArena &arena) :
+            _image(image), _symbols(symbols), _arena(arena) {
+        _header = readHeader(image);
+        // Sizes are summed in 64 bits, so they can't wrap around.
+        if (sizeof(Header) + uint64_t(_header.stringSize) + _header.nodeSize != image.size())
+            _corrupt("its size doesn't match its header");
+    }
+
+    static Header readHeader(std::string_view image) {
+        Header header{};
+        if (image.size() < sizeof(Header))
+            _corrupt("it is too short");
+        std::memcpy(&header, image.data(), sizeof(Header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+            _corrupt("it has no AST image header");
+        if (header.version != AstSerializer::kVersion)
+            _corrupt("it is of another version");
+        return header;
+    }
+
+    std::vector<AST *> read() {
+        _position = sizeof(Header);
+        _end = _position + _header.stringSize;
+        // Every string takes a byte at least, so the count is checked before it is allocated.
+        if (_header.stringCount > _header.stringSize)
+            _corrupt("a string is out of bounds");
+        _symbolTable.resize(_header.stringCount + 1, nullptr);
+        for (uint32_t i = 0; i < _header.stringCount; ++i) {
+            const uint32_t length = _uint();
+            if (length > _end - _position)
+                _corrupt("a string is out of bounds");
+            _symbolTable[i + 1] = _symbols.intern(_image.substr(_position, length));
+            _position += length;
+        }
+        if (_position != _end)
+            _corrupt("its strings don't match their size");
+
+        _end = _image.size();
+        std::vector<AST *> ast;
+        ast.reserve(std::min<uint64_t>(_header.rootCount, _end - _position));
+        for (uint32_t i = 0; i < _header.rootCount; ++i) {
+            auto root = _node<AST>();
+            if (!root)
+                _corrupt("a top-level node is missing");
+            ast.push_back(root);
+        }
+        if (_position != _end)
+            _corrupt("there is more after its last node");
+        return ast;
+    }
+
+private:
+    [[noreturn]] static void _corrupt(const char *reason) {
+        throw std::runtime_error(std::string("Not a usable AST image: ") + reason + ".");
+    }
+
+    uint32_t _uint() {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 35; shift += 7) {
+            if (_position == _end)
+                _corrupt("it ends in the middle of a node");
+            const auto byte = uint8_t(_image[_position++]);
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                if (value > UINT32_MAX)
+                    _corrupt("a number is out of range");
+                return uint32_t(value);
+            }
+        }
+        _corrupt("a number is out of range");
+    }
+
+    // The size of a list, which can't be more than the bytes left, as every element takes one at
+    // least.
+    uint32_t _count() {
+        const uint32_t count = _uint();
+        if (count > _end - _position)
+            _corrupt("a list is out of bounds");
+        return count;
+    }
+
+    AST *_make(uint32_t kind) {
+        if (kind >= kNodeKindCount)
+            _corrupt("a node is of an unknown kind");
+        const auto nodeKind = static_cast<NodeKind>(kind);
+        switch (nodeKind) {
+            case NodeKind::Alias:
+                return _arena.make<AliasNode>();
+            case NodeKind::Struct:
+                return _arena.make<StructNode>();
+            case NodeKind::Member:
+                return _arena.make<MemberNode>();
+            case NodeKind::Var:
+                return _arena.make<VarNode>();
+            case NodeKind::Let:
+                return _arena.make<LetNode>();
+            case NodeKind::Function:
+                return _arena.make<FunctionNode>();
+            case NodeKind::Arg:
+                return _arena.make<ArgNode>();
+            case NodeKind::Attribute:
+                return _arena.make<AttributeNode>();
+            case NodeKind::Type:
+            case NodeKind::Array:
+            case NodeKind::Sampler:
+                return _arena.make<TypeNode>(nodeKind);
+            case NodeKind::Create:
+                return _arena.make<CreateNode>();
+            case NodeKind::Block:
+                return _arena.make<BlockNode>();
+            case NodeKind::VarStatement:
+                return _arena.make<VarStatementNode>();
+            case NodeKind::Assign:
+                return _arena.make<AssignNode>();
+            case NodeKind::Call:
+                return _arena.make<CallNode>();
+            case NodeKind::If:
+            case NodeKind::ElseIf:
+                return _arena.make<IfNode>(nodeKind);
+            case NodeKind::Switch:
+                return _arena.make<SwitchNode>();
+            case NodeKind::Case:
+            case NodeKind::Default:
+                return _arena.make<CaseNode>(nodeKind);
+            case NodeKind::Loop:
+                return _arena.make<LoopNode>();
+            case NodeKind::For:
+                return _arena.make<ForNode>();
+            case NodeKind::While:
+                return _arena.make<WhileNode>();
+            case NodeKind::Return:
+                return _arena.make<ReturnNode>();
+            case NodeKind::CompareOp:
+            case NodeKind::BinaryOp:
+                return _arena.make<BinaryOpNode>(nodeKind);
+            case NodeKind::UnaryOp:
+                return _arena.make<UnaryOpNode>();
+            case NodeKind::CallExpr:
+                return _arena.make<CallExprNode>();
+            case NodeKind::VariableExpr:
+            case NodeKind::LiteralExpr:
+                return _arena.make<ExprNode>(nodeKind);
+            case NodeKind::BitcastExpr:
+            case NodeKind::TypecastExpr:
+                return _arena.make<CastExprNode>(nodeKind);
+            case NodeKind::GroupingExpr:
+                return _arena.make<GroupingExprNode>();
+            default:
+                return _arena.make<AST>(nodeKind);
+        }
+    }
+
+    // Reads a node and its children, in the order the Writer wrote them. The node has to be a T.
+    template<typename T>
+    T *_node() {
+        const uint32_t kind = _uint();
+        if (kind == 0)
+            return nullptr;
+        if (++_depth > kMaxDepth)
+            _corrupt("its nodes are nested too deeply");
+        auto node = _make(kind - 1);
+        T *typed;
+        if constexpr (std::is_same_v<T, AST>) {
+            typed = node;
+        } else {
+            typed = node->template as<T>();
+            if (!typed)
+                _corrupt("a node is of the wrong kind");
+        }
+        _fields(node);
+        --_depth;
+        return typed;
+    }
+
+    void _fields(AST *node) {
+        if (auto name = _symbol())
+            node->setName(name);
+        if (auto expr = node->as<ExprNode>())
+            expr->postfix = _node<ExprNode>();
+
+        switch (node->kind()) {
+            case NodeKind::Alias:
+                node->as<AliasNode>()->alias = _node<TypeNode>();
+                break;
+            case NodeKind::Struct: {
+                auto n = node->as<StructNode>();
+                n->attributes = _list();
+                n->members = _list();
+                break;
+            }
+            case NodeKind::Member: {
+                auto n = node->as<MemberNode>();
+                n->attributes = _list();
+                n->type = _node<TypeNode>();
+                break;
+            }
+            case NodeKind::Var: {
+                auto n = node->as<VarNode>();
+                n->attributes = _list();
+                n->storage = _string();
+                n->access = _string();
+                n->type = _node<TypeNode>();
+                n->value = _node<AST>();
+                n->setGroup(_uint());
+                n->setBinding(_uint());
+                break;
+            }
+            case NodeKind::Let: {
+                auto n = node->as<LetNode>();
+                n->attributes = _list();
+                n->type = _node<TypeNode>();
+                n->value = _node<AST>();
+                break;
+            }
+            case NodeKind::Function: {
+                auto n = node->as<FunctionNode>();
+                n->attributes = _list();
+                n->args = _list();
+                n->returnType = _node<TypeNode>();
+                n->body = _node<BlockNode>();
+                n->bodyOffset = _uint();
+                n->bodyLength = _uint();
+                n->bodyLine = _uint();
+                break;
+            }
+            case NodeKind::Arg: {
+                auto n = node->as<ArgNode>();
+                n->attributes = _list();
+                n->type = _node<TypeNode>();
+                break;
+            }
+            case NodeKind::Attribute: {
+                auto n = node->as<AttributeNode>();
+                n->values = _stringList();
+                n->tokens = _tokens();
+                break;
+            }
+            case NodeKind::Type:
+            case NodeKind::Array:
+            case NodeKind::Sampler: {
+                auto n = node->as<TypeNode>();
+                n->attributes = _list();
+                n->format = _node<TypeNode>();
+                n->decl = _node<TypeNode>();
+                n->access = _string();
+                n->count = _uint();
+                n->countName = _string();
+                break;
+            }
+            case NodeKind::Create: {
+                auto n = node->as<CreateNode>();
+                n->type = _node<TypeNode>();
+                n->args = _list();
+                break;
+            }
+            case NodeKind::Block:
+                node->as<BlockNode>()->statements = _list();
+                break;
+            case NodeKind::VarStatement: {
+                auto n = node->as<VarStatementNode>();
+                n->var = _node<VarNode>();
+                n->value = _node<ExprNode>();
+                break;
+            }
+            case NodeKind::Assign: {
+                auto n = node->as<AssignNode>();
+                n->var = _node<ExprNode>();
+                n->value = _node<ExprNode>();
+                break;
+            }
+            case NodeKind::Call:
+                node->as<CallNode>()->args = _list();
+                break;
+            case NodeKind::If:
+            case NodeKind::ElseIf: {
+                auto n = node->as<IfNode>();
+                n->condition = _node<ExprNode>();
+                n->block = _node<BlockNode>();
+                n->elseif = _list();
+                n->elseBlock = _node<BlockNode>();
+                break;
+            }
+            case NodeKind::Switch: {
+                auto n = node->as<SwitchNode>();
+                n->condition = _node<ExprNode>();
+                n->body = _list();
+                break;
+            }
+            case NodeKind::Case:
+            case NodeKind::Default: {
+                auto n = node->as<CaseNode>();
+                n->selectors = _stringList();
+                n->body = _list();
+                break;
+            }
+            case NodeKind::Loop: {
+                auto n = node->as<LoopNode>();
+                n->statements = _list();
+                n->continuing = _node<BlockNode>();
+                break;
+            }
+            case NodeKind::For: {
+                auto n = node->as<ForNode>();
+                n->init = _node<AST>();
+                n->condition = _node<ExprNode>();
+                n->increment = _node<AST>();
+                n->body = _node<BlockNode>();
+                break;
+            }
+            case NodeKind::While: {
+                auto n = node->as<WhileNode>();
+                n->condition = _node<ExprNode>();
+                n->block = _node<BlockNode>();
+                break;
+            }
+            case NodeKind::Return:
+                node->as<ReturnNode>()->value = _node<ExprNode>();
+                break;
+            case NodeKind::CompareOp:
+            case NodeKind::BinaryOp: {
+                auto n = node->as<BinaryOpNode>();
+                n->left = _node<ExprNode>();
+                n->right = _node<ExprNode>();
+                break;
+            }
+            case NodeKind::UnaryOp:
+                node->as<UnaryOpNode>()->right = _node<ExprNode>();
+                break;
+            case NodeKind::CallExpr:
+                node->as<CallExprNode>()->args = _list();
+                break;
+            case NodeKind::BitcastExpr:
+            case NodeKind::TypecastExpr: {
+                auto n = node->as<CastExprNode>();
+                n->type = _node<TypeNode>();
+                n->value = _node<ExprNode>();
+                n->args = _list();
+                break;
+            }
+            case NodeKind::GroupingExpr:
+                node->as<GroupingExprNode>()->expr = _node<ExprNode>();
+                break;
+            default:
+                break;
+        }
+    }
+
+    // The elements of nested lists are gathered on one stack, from the end they started at, so
+    // reading a list doesn't allocate for every level.
+    ArenaSpan<AST *> _list() {
+        const uint32_t count = _count();
+        const size_t start = _items.size();
+        for (uint32_t i = 0; i < count; ++i)
+            _items.push_back(_node<AST>());
+        auto list = _arena.copy(_items.data() + start, count);
+        _items.resize(start);
+        return list;
+    }
+
+    ArenaSpan<std::string_view> _stringList() {
+        const uint32_t count = _count();
+        _texts.clear();
+        for (uint32_t i = 0; i < count; ++i)
+            _texts.push_back(_string());
+        return _arena.copy(_texts);
+    }
+
+    TokenSpan _tokens() {
+        const uint32_t count = _count();
+        if (count == 0)
+            return {};
+        auto tokens = static_cast<Token *>(_arena.allocate(count * sizeof(Token), alignof(Token)));
+        for (uint32_t i = 0; i < count; ++i) {
+            auto &token = tokens[i];
+            const uint32_t kind = _uint();
+            if (kind >= Token::Types().size())
+                _corrupt("a token is of an unknown kind");
+            token._kind = uint16_t(kind);
+            token._offset = _uint();
+            const uint32_t length = _uint();
+            if (length > UINT16_MAX)
+                _corrupt("a token is out of range");
+            token._length = uint16_t(length);
+            token._line = _uint();
+            token._value.u = _uint();
+            if (token.kind() == TokenKind::Ident && token.symbolId() != 0) {
+                auto symbol = _symbol(token.symbolId());
+                token._value.u = symbol ? symbol->id : 0;
+            }
+        }
+        return {tokens, count};
+    }
+
+    const Symbol *_symbol(uint32_t ref) {
+        if (ref >= _symbolTable.size())
+            _corrupt("a string is out of bounds");
+        return _symbolTable[ref];
+    }
+
+    const Symbol *_symbol() {
+        return _symbol(_uint());
+    }
+
+    std::string_view _string() {
+        auto symbol = _symbol();
+        return symbol ? symbol->text : std::string_view();
+    }
+
+    std::string_view _image;
+    SymbolTable &_symbols;
+    AstArena &_arena;
+    Header _header{};
+    // The next byte to read, and the end of the section it is in.
+    uint64_t _position = 0;
+    uint64_t _end = 0;
+    uint32_t _depth = 0;
+    // The symbols of the strings by index + 1; null at 0.
+    std::vector<const Symbol *> _symbolTable;
+    // Reused while reading lists.
+    std::vector<AST *> _items;
+    std::vector<std::string_view> _texts;
+};
+
+std::string AstSerializer::write(std::string_view source, const std::vector<AST *> &ast) {
+    return Writer(source).write(ast);
+}
+
+std::vector<AST *> AstSerializer::read(std::string_view image, SymbolTable &symbols, AstArena &arena) {
+    return Reader(image, symbols, arena).read();
+}
+
+uint64_t AstSerializer::sourceHash(std::string_view image) {
+    return Reader::readHeader(image).sourceHash;
+}
+
+uint32_t AstSerializer::sourceSize(std::string_view image) {
+    return Reader::readHeader(image).sourceSize;
+}
+
+uint64_t AstSerializer::hash(std::string_view source) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c: source)
+        hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+    return hash;
+}
@@ -0,0 +1,67 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_AST_SERIALIZER_H
+#define WGSL_INTROSPECTOR_WGSL_AST_SERIALIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "wgsl_ast.h"
+
+//MARK: - AstSerializer
+// Writes the ASTs of a parse to a compact binary image, and loads them back, so modules that
+// are parsed over and over can be cached. An image is position independent, so it can be loaded
+// straight from one read of a file, or from a MappedFile:
+//
+//   header     magic, version, the hash and size of the source, and the sizes of the sections
+//   strings    the length and text of every distinct string
+//   nodes      the top-level nodes, each followed by its children, in preorder
+//
+// Past the header everything is LEB128 numbers and bytes. A node is its kind + 1, 0 standing for
+// no node, its name, then only the fields of its kind: children inline, lists as a count and
+// their elements, strings as their index + 1. A leaf takes two or three bytes, so an image is
+// about the size of its source.
+//
+// This trades walking an image in place for its size. Records of one fixed size, which children
+// can refer to by offset, made images about 13 times the size of their source, mostly fields
+// that leaves don't have; and the ASTs are structs of pointers, so even those records had to be
+// linked into an arena before the reflection could use them. Variable-length records can't be
+// found by offset, so an image is always loaded, in one pass, before it is walked.
+//
+// Loading reads the nodes in one recursive pass; there is no scanning or parsing. Tokens keep
+// their offsets into the source, so the hash and size of the source are kept, for callers to
+// check that an image belongs to the source they have.
+class AstSerializer {
+public:
+    // Bumped whenever the layout of an image, or of the ASTs, changes.
+    static constexpr uint32_t kVersion = 5;
+
+    // Serializes ast, parsed from source.
+    static std::string write(std::string_view source, const std::vector<AST *> &ast);
+
+    // Loads the ASTs of image, interning their names in symbols and allocating their nodes in
+    // arena, which both have to outlive them. The image isn't needed after. Throws
+    // std::runtime_error if image isn't a whole, consistent image of this version.
+    static std::vector<AST *> read(std::string_view image, SymbolTable &symbols, AstArena &arena);
+
+    // The hash of the source image was written from. Throws like read.
+    static uint64_t sourceHash(std::string_view image);
+
+    // The size of the source image was written from, a check on top of the hash. Throws like
+    // read.
+    static uint32_t sourceSize(std::string_view image);
+
+    // A 64-bit FNV-1a hash of source.
+    static uint64_t hash(std::string_view source);
+
+private:
+    class Writer;
+
+    class Reader;
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_AST_SERIALIZER_H
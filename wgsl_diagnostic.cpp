@@ -0,0 +1,24 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_diagnostic.h"
+#include <utility>
+
+Diagnostic::Diagnostic(Kind kind, std::string message, std::string_view source, size_t offset,
+                       size_t length, size_t line) :
+        kind(kind),
+        message(std::move(message)),
+        line(static_cast<uint32_t>(line)),
+        offset(static_cast<uint32_t>(offset)),
+        length(static_cast<uint32_t>(length)) {
+    // Only errors need a column, so it isn't tracked while scanning.
+    const auto lineStart = source.substr(0, offset).rfind('\n');
+    column = static_cast<uint32_t>(lineStart == std::string_view::npos ? offset + 1 : offset - lineStart);
+}
+
+std::string Diagnostic::toString() const {
+    return std::to_string(line) + ":" + std::to_string(column) + ": " + message;
+}
@@ -0,0 +1,41 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_DIAGNOSTIC_H
+#define WGSL_INTROSPECTOR_WGSL_DIAGNOSTIC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//MARK: - Diagnostic
+// An error in a shader, and the span of source it is about. Lines and columns start at 1;
+// columns count bytes.
+struct Diagnostic {
+    enum class Kind : uint8_t {
+        // A character no token starts with. The scanner skips it.
+        InvalidCharacter,
+        // A numeric literal that doesn't fit its type.
+        LiteralOutOfRange,
+        // A token the grammar doesn't allow where it is.
+        UnexpectedToken
+    };
+
+    Diagnostic(Kind kind, std::string message, std::string_view source, size_t offset, size_t length,
+               size_t line);
+
+    // "line:column: message", the text of the exception thrown when nothing collects diagnostics.
+    [[nodiscard]] std::string toString() const;
+
+    Kind kind;
+    std::string message;
+    uint32_t line;
+    uint32_t column;
+    uint32_t offset;
+    uint32_t length;
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_DIAGNOSTIC_H
@@ -0,0 +1,92 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_mapped_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &path) {
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Unable to open " + path);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size)) {
+        CloseHandle(_file);
+        throw std::runtime_error("Unable to read the size of " + path);
+    }
+    _size = static_cast<size_t>(size.QuadPart);
+
+    // An empty file can't be mapped, it's just an empty view.
+    if (_size == 0)
+        return;
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping)
+        _data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!_data) {
+        if (_mapping)
+            CloseHandle(_mapping);
+        CloseHandle(_file);
+        throw std::runtime_error("Unable to map " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file && _file != INVALID_HANDLE_VALUE)
+        CloseHandle(_file);
+}
+#else
+MappedFile::MappedFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Unable to open " + path);
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Unable to read the size of " + path);
+    }
+    _size = static_cast<size_t>(info.st_size);
+
+    // An empty file can't be mapped, it's just an empty view.
+    if (_size > 0) {
+        void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Unable to map " + path);
+        }
+        // The scanner reads the mapping front to back, once.
+        madvise(data, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char *>(data);
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data)
+        munmap(const_cast<char *>(_data), _size);
+}
+#endif
@@ -0,0 +1,38 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_MAPPED_FILE_H
+#define WGSL_INTROSPECTOR_WGSL_MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+// A file mapped read-only into memory, so it can be scanned without reading it into a string.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] std::string_view view() const {
+        return {_data, _size};
+    }
+
+private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void *_file = nullptr;
+    void *_mapping = nullptr;
+#endif
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_MAPPED_FILE_H
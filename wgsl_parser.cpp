@@ -6,109 +6,337 @@
 
 #include "wgsl_parser.h"
 #include <memory>
+#include <stdexcept>
+
+namespace {
+// Where parsing can go on after an error. var and let start both declarations and statements;
+// the other declaration keywords can't be in a function body.
+constexpr TokenKindSet kDeclarationKeyword{
+        TokenKind::Fn, TokenKind::Struct, TokenKind::Type, TokenKind::Enable, TokenKind::Attr, TokenKind::AttrLeft};
+constexpr TokenKindSet kDeclarationStart = kDeclarationKeyword | TokenKindSet{TokenKind::Var, TokenKind::Let};
+constexpr TokenKindSet kStatementStart{
+        TokenKind::Var, TokenKind::Let, TokenKind::If, TokenKind::Switch, TokenKind::Loop, TokenKind::For,
+        TokenKind::While, TokenKind::Return, TokenKind::Break, TokenKind::Continue, TokenKind::Discard};
+// The tokens after the statements of a block, loop or case body. A declaration keyword there
+// means the body is missing its '}'.
+constexpr TokenKindSet kStatementListEnd =
+        kDeclarationKeyword | TokenKindSet{TokenKind::BraceRight, TokenKind::Continuing, TokenKind::Fallthrough};
+
+// Tokens whose text is never the name of a node.
+constexpr TokenKindSet kUnnamed{
+        TokenKind::ParenLeft, TokenKind::ParenRight, TokenKind::BraceLeft, TokenKind::BraceRight,
+        TokenKind::BracketLeft, TokenKind::BracketRight, TokenKind::Semicolon, TokenKind::Comma, TokenKind::Colon,
+        TokenKind::Period, TokenKind::Arrow, TokenKind::Equal, TokenKind::Attr, TokenKind::AttrLeft,
+        TokenKind::AttrRight, TokenKind::Eof};
+
+// A parallel parse splits a module into a few runs of declarations per thread, so threads that
+// finish early can take over runs from the others.
+constexpr size_t kRunsPerThread = 4;
+// Runs smaller than this aren't worth a task.
+constexpr size_t kMinRunTokens = 4096;
+
+// Splits tokens, up to their EOF token, into about count runs of whole top-level declarations.
+// Runs start at a declaration keyword after a ';' or a '}' outside of braces. The parser never
+// skips past one after an error, and a statement list ends at it, so a run parses as it would
+// in the whole module, errors included.
+std::vector<std::pair<size_t, size_t>> splitDeclarations(TokenSpan tokens, size_t count) {
+    std::vector<std::pair<size_t, size_t>> runs;
+    const size_t size = tokens.empty() ? 0 : tokens.size() - 1;
+    const size_t target = std::max(kMinRunTokens, size / std::max<size_t>(count, 1));
+    size_t begin = 0;
+    size_t depth = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const auto kind = tokens[i].kind();
+        if (kind == TokenKind::BraceLeft) {
+            depth++;
+            continue;
+        }
+        if (kind == TokenKind::BraceRight && depth > 0)
+            depth--;
+        else if (kind != TokenKind::Semicolon || depth > 0)
+            continue;
+        if (depth == 0 && i + 1 - begin >= target && size - (i + 1) >= target / 2 &&
+            kDeclarationKeyword.contains(tokens[i + 1].kind())) {
+            runs.emplace_back(begin, i + 1);
+            begin = i + 1;
+        }
+    }
+    runs.emplace_back(begin, size);
+    return runs;
+}
 
-const std::vector<std::unique_ptr<AST>> AST::Empty = {};
-const std::vector<std::string> AST::EmptyString = {};
+// The binary operators by token kind, with how tight they bind: from short_circuit_or_expression
+// at 1 to multiplicative_expression at 10. 0 is not an operator.
+struct BinaryOperator {
+    uint8_t precedence;
+    NodeKind kind;
+};
+
+constexpr uint8_t kEqualityPrecedence = 6;
+
+constexpr TokenKindSet kUnaryOperators{
+        TokenKind::Minus, TokenKind::Bang, TokenKind::Tilde, TokenKind::Star, TokenKind::And};
+
+constexpr auto kBinaryOperators = [] {
+    std::array<BinaryOperator, static_cast<size_t>(TokenKind::Count)> operators{};
+    const auto add = [&](std::initializer_list<TokenKind> kinds, uint8_t precedence, NodeKind kind) {
+        for (const auto token: kinds)
+            operators[static_cast<size_t>(token)] = {precedence, kind};
+    };
+    add({TokenKind::OrOr}, 1, NodeKind::CompareOp);
+    add({TokenKind::AndAnd}, 2, NodeKind::CompareOp);
+    add({TokenKind::Or}, 3, NodeKind::BinaryOp);
+    add({TokenKind::Xor}, 4, NodeKind::BinaryOp);
+    add({TokenKind::And}, 5, NodeKind::BinaryOp);
+    add({TokenKind::EqualEqual, TokenKind::NotEqual}, kEqualityPrecedence, NodeKind::CompareOp);
+    add({TokenKind::LessThan, TokenKind::GreaterThan, TokenKind::LessThanEqual, TokenKind::GreaterThanEqual},
+        7, NodeKind::CompareOp);
+    add({TokenKind::ShiftLeft, TokenKind::ShiftRight}, 8, NodeKind::BinaryOp);
+    add({TokenKind::Plus, TokenKind::Minus}, 9, NodeKind::BinaryOp);
+    add({TokenKind::Star, TokenKind::ForwardSlash, TokenKind::Modulo}, 10, NodeKind::BinaryOp);
+    return operators;
+}();
+}
 
-std::vector<std::unique_ptr<AST>> WgslParser::parse(const std::string &code) {
-    _initialize(code);
+std::vector<AST *> WgslParser::parse(const std::string &code) {
+    auto scanner = WgslScanner(code);
+    scanner.setSymbolTable(&_symbols);
+    return parse(scanner);
+}
 
-    std::vector<std::unique_ptr<AST>> statements{};
-    while (!_isAtEnd()) {
-        auto statement = _global_decl_or_directive();
-        if (!statement)
-            break;
-        statements.emplace_back(std::move(statement));
+std::vector<AST *> WgslParser::parse(std::string_view source, TokenSpan tokens) {
+    _ownedTokens = {};
+    _initialize(source, tokens);
+    return _parseAll();
+}
+
+std::vector<AST *> WgslParser::parse(std::string_view source, TokenSpan tokens, ThreadPool &pool) {
+    if (pool.size() < 2)
+        return parse(source, tokens);
+    const auto runs = splitDeclarations(tokens, pool.size() * kRunsPerThread);
+    if (runs.size() < 2)
+        return parse(source, tokens);
+
+    // The symbol table can't be written concurrently, so every name the parsers could look up
+    // is interned first, and they only read it.
+    for (const auto &token: tokens) {
+        if (!kUnnamed.contains(token.kind()) && !(token.kind() == TokenKind::Ident && token.symbolId() != 0))
+            _symbols.intern(token.lexeme(source));
+    }
+
+    struct Run {
+        AstArena arena;
+        std::vector<AST *> ast;
+        std::vector<Diagnostic> diagnostics;
+    };
+    std::vector<Run> results(runs.size());
+    pool.parallelFor(runs.size(), [&](size_t i) {
+        const auto [begin, end] = runs[i];
+        WgslParser parser(_symbols, results[i].arena, _mode);
+        parser._intern = false;
+        if (_diagnostics)
+            parser.setDiagnostics(&results[i].diagnostics);
+        parser._initialize(source, TokenSpan(tokens.data() + begin, end - begin));
+        parser._end = tokens[end];
+        results[i].ast = parser._parseAll();
+    });
+
+    _ownedTokens = {};
+    _initialize(source, tokens);
+    _current = tokens.size();
+    std::vector<AST *> statements{};
+    for (auto &result: results) {
+        _arena.adopt(std::move(result.arena));
+        statements.insert(statements.end(), result.ast.begin(), result.ast.end());
+        if (_diagnostics)
+            _diagnostics->insert(_diagnostics->end(), result.diagnostics.begin(), result.diagnostics.end());
     }
     return statements;
 }
 
-std::vector<std::unique_ptr<AST>> WgslParser::parse(const std::vector<Token> &tokens) {
-    _initialize(tokens);
+std::vector<AST *> WgslParser::parse(std::string_view source, std::vector<Token> &&tokens) {
+    _ownedTokens = std::move(tokens);
+    _initialize(source, _ownedTokens);
+    return _parseAll();
+}
 
-    std::vector<std::unique_ptr<AST>> statements{};
-    while (!_isAtEnd()) {
-        auto statement = _global_decl_or_directive();
-        if (!statement)
-            break;
-        statements.emplace_back(std::move(statement));
+std::vector<AST *> WgslParser::parse(WgslScanner &scanner) {
+    beginStream(scanner);
+    return _parseAll();
+}
+
+std::vector<AST *> WgslParser::_parseAll() {
+    std::vector<AST *> statements{};
+    while (auto statement = parseNext()) {
+        statements.emplace_back(statement);
     }
     return statements;
 }
 
-void WgslParser::_initialize(const std::string &code) {
-    auto scanner = WgslScanner(code);
-    _tokens = scanner.scanTokens();
+void WgslParser::beginStream(WgslScanner &scanner) {
+    _tokens = {};
+    _ownedTokens = {};
+    _source = scanner.source();
     _current = 0;
+    _panic = false;
+    _scanner = &scanner;
+    // Most identifiers of a declarations parse are in skipped bodies, so the parser interns the
+    // ones it keeps itself.
+    _scanner->setSymbolTable(_mode == ParseMode::Full ? &_symbols : nullptr);
+    if (_diagnostics)
+        _scanner->setDiagnostics(_diagnostics);
+    _pulled = 0;
+}
+
+AST *WgslParser::parseNext() {
+    for (;;) {
+        if (_isAtEnd())
+            return nullptr;
+        const size_t start = _current;
+        auto decl = _global_decl_or_directive();
+        if (!_panic)
+            return decl;
+
+        _synchronize(false);
+        if (_current == start)
+            _advance();
+    }
 }
 
-void WgslParser::_initialize(const std::vector<Token> &tokens) {
+BlockNode *WgslParser::parseBody(FunctionNode *function, WgslScanner &scanner) {
+    if (function->body)
+        return function->body;
+
+    scanner.seek(function->bodyOffset, function->bodyLine);
+    beginStream(scanner);
+    scanner.setSymbolTable(&_symbols);
+    function->body = _compound_statement();
+    return function->body;
+}
+
+void WgslParser::_initialize(std::string_view source, TokenSpan tokens) {
     _tokens = tokens;
+    _end = Token(TokenKind::Eof, source.size(), 0, tokens.empty() ? 1 : tokens[tokens.size() - 1].line());
+    _source = source;
     _current = 0;
+    _panic = false;
+    _scanner = nullptr;
+}
+
+const Symbol *WgslParser::_symbol(const Token &token) {
+    // Identifiers usually come interned by the scanner, anything else is interned here.
+    if (token.kind() == TokenKind::Ident && token.symbolId() != 0)
+        return _symbols.symbol(token.symbolId());
+    return _intern ? _symbols.intern(token.lexeme(_source)) : _symbols.find(token.lexeme(_source));
 }
 
-void WgslParser::_error(const Token &token, const std::string &message) {
+const Token &WgslParser::_token(size_t index) {
+    if (!_scanner)
+        return index < _tokens.size() ? _tokens[index] : _end;
 
+    while (_pulled <= index) {
+        _window[_pulled % kTokenWindow] = _scanner->nextToken();
+        _pulled++;
+    }
+    // The token was overwritten by a later one; going on would parse the wrong one silently.
+    if (index + kTokenWindow < _pulled)
+        throw std::logic_error("The parser backtracked past its streaming token window.");
+    return _window[index % kTokenWindow];
+}
+
+void WgslParser::_error(const Token &token, const char *message) {
+    if (!_diagnostics)
+        throw std::runtime_error(
+                Diagnostic(Diagnostic::Kind::UnexpectedToken, message, _source, token._offset, token._length,
+                           token._line).toString());
+    if (!_panic)
+        _diagnostics->emplace_back(Diagnostic::Kind::UnexpectedToken, message, _source, token._offset,
+                                   token._length, token._line);
+    _panic = true;
+}
+
+void WgslParser::_synchronize(bool inStatementList) {
+    _panic = false;
+    // Braces opened while skipping; the blocks in them are skipped whole.
+    size_t depth = 0;
+    while (!_isAtEnd()) {
+        const auto kind = _peek().kind();
+        if (depth == 0) {
+            if (kind == TokenKind::Semicolon) {
+                _advance();
+                return;
+            }
+            if (inStatementList && (kStatementStart.contains(kind) || kStatementListEnd.contains(kind)))
+                return;
+            if (!inStatementList && kDeclarationStart.contains(kind))
+                return;
+        }
+        if (kind == TokenKind::BraceLeft) {
+            depth++;
+        } else if (kind == TokenKind::BraceRight && depth > 0 && --depth == 0) {
+            _advance();
+            return;
+        }
+        _advance();
+    }
 }
 
 bool WgslParser::_isAtEnd() {
-    return _current >= _tokens.size() || _peek()._type == Token::TokenEOF;
+    return _panic || (!_scanner && _current >= _tokens.size()) || _peek().kind() == TokenKind::Eof;
 }
 
-bool WgslParser::_match(const TokenType &types) {
-    if (_check(types)) {
+bool WgslParser::_match(TokenKind kind) {
+    if (_check(kind)) {
         _advance();
         return true;
     }
     return false;
 }
 
-bool WgslParser::_match(const std::vector<TokenType> &types) {
-    for (const auto &type: types) {
-        if (_check(type)) {
-            _advance();
-            return true;
-        }
+bool WgslParser::_match(const TokenKindSet &kinds) {
+    if (_check(kinds)) {
+        _advance();
+        return true;
     }
-
     return false;
 }
 
-bool WgslParser::_check(const TokenType &types) {
+bool WgslParser::_check(TokenKind kind) {
     if (_isAtEnd()) return false;
-    return _peek()._type == types;
+    return _peek().kind() == kind;
 }
 
-bool WgslParser::_check(const std::vector<TokenType> &types) {
+bool WgslParser::_check(const TokenKindSet &kinds) {
     if (_isAtEnd()) return false;
-    const auto iter = std::find(types.begin(), types.end(), _peek()._type);
-    return iter != types.end();
+    return kinds.contains(_peek().kind());
 }
 
-Token WgslParser::_consume(const TokenType &types, const std::string &message) {
-    if (_check(types)) return _advance();
-    throw std::runtime_error(message);
+const Token &WgslParser::_consume(TokenKind kind, const char *message) {
+    if (_check(kind)) return _advance();
+    _error(_peek(), message);
+    return _peek();
 }
 
-Token WgslParser::_consume(const std::vector<TokenType> &types, const std::string &message) {
-    if (_check(types)) return _advance();
-    throw std::runtime_error(message);
+const Token &WgslParser::_consume(const TokenKindSet &kinds, const char *message) {
+    if (_check(kinds)) return _advance();
+    _error(_peek(), message);
+    return _peek();
 }
 
-Token WgslParser::_advance() {
+const Token &WgslParser::_advance() {
     if (!_isAtEnd()) _current++;
     return _previous();
 }
 
-Token WgslParser::_peek() {
-    return _tokens[_current];
+const Token &WgslParser::_peek() {
+    return _token(_current);
 }
 
-Token WgslParser::_previous() {
-    return _tokens[_current - 1];
+const Token &WgslParser::_previous() {
+    return _token(_current - 1);
 }
 
-std::unique_ptr<AST> WgslParser::_global_decl_or_directive() {
+AST *WgslParser::_global_decl_or_directive() {
     // semicolon
     // global_variable_decl semicolon
     // global_constant_decl semicolon
@@ -118,119 +346,157 @@ std::unique_ptr<AST> WgslParser::_global_decl_or_directive() {
     // enable_directive
 
     // Ignore any stand-alone semicolons
-    while (_match(Token::Tokens["semicolon"]) && !_isAtEnd());
+    while (_match(TokenKind::Semicolon) && !_isAtEnd());
+    if (_isAtEnd())
+        return nullptr;
 
-    if (_match(Token::Keywords["type"])) {
+    if (_match(TokenKind::Type)) {
         auto type = _type_alias();
-        _consume(Token::Tokens["semicolon"], "Expected ';'");
+        _consume(TokenKind::Semicolon, "Expected ';'");
         return type;
     }
 
-    if (_match(Token::Keywords["enable"])) {
+    if (_match(TokenKind::Enable)) {
         auto enable = _enable_directive();
-        _consume(Token::Tokens["semicolon"], "Expected ';'");
+        _consume(TokenKind::Semicolon, "Expected ';'");
         return enable;
     }
 
     // The following statements have an optional attribute*
     auto attrs = _attribute();
 
-    if (_check(Token::Keywords["var"])) {
+    if (_check(TokenKind::Var)) {
         auto _var = _global_variable_decl();
-        _var->setChildVec("attributes", std::move(attrs));
-        _consume(Token::Tokens["semicolon"], "Expected ';'.");
+        _var->attributes = _arena.copy(attrs);
+        _consume(TokenKind::Semicolon, "Expected ';'.");
         return _var;
     }
 
-    if (_check(Token::Keywords["let"])) {
+    if (_check(TokenKind::Let)) {
         auto _let = _global_constant_decl();
-        _let->setChildVec("attributes", std::move(attrs));
-        _consume(Token::Tokens["semicolon"], "Expected ';'.");
+        _let->attributes = _arena.copy(attrs);
+        _consume(TokenKind::Semicolon, "Expected ';'.");
         return _let;
     }
 
-    if (_check(Token::Keywords["struct"])) {
+    if (_check(TokenKind::Struct)) {
         auto _struct = _struct_decl();
-        _struct->setChildVec("attributes", std::move(attrs));
+        _struct->attributes = _arena.copy(attrs);
         return _struct;
     }
 
-    if (_check(Token::Keywords["fn"])) {
+    if (_check(TokenKind::Fn)) {
         auto _fn = _function_decl();
-        _fn->setChildVec("attributes", std::move(attrs));
+        _fn->attributes = _arena.copy(attrs);
         return _fn;
     }
 
+    _error(_peek(), "Expected a declaration.");
     return nullptr;
 }
 
-std::unique_ptr<AST> WgslParser::_function_decl() {
+FunctionNode *WgslParser::_function_decl() {
     // attribute* function_header compound_statement
     // function_header: fn ident paren_left param_list? paren_right (arrow attribute* type_decl)?
-    if (!_match(Token::Keywords["fn"]))
+    if (!_match(TokenKind::Fn))
         return nullptr;
 
-    auto name = _consume(Token::Tokens["ident"], "Expected function name.").toString();
+    auto name = _symbol(_consume(TokenKind::Ident, "Expected function name."));
 
-    _consume(Token::Tokens["paren_left"], "Expected '(' for function arguments.");
+    _consume(TokenKind::ParenLeft, "Expected '(' for function arguments.");
 
-    std::vector<std::unique_ptr<AST>> args{};
-    if (!_check(Token::Tokens["paren_right"])) {
+    std::vector<AST *> args{};
+    if (!_check(TokenKind::ParenRight)) {
         do {
             auto argAttrs = _attribute();
 
-            auto name = _consume(Token::Tokens["ident"], "Expected argument name.").toString();
+            auto name = _symbol(_consume(TokenKind::Ident, "Expected argument name."));
 
-            _consume(Token::Tokens["colon"], "Expected ':' for argument type.");
+            _consume(TokenKind::Colon, "Expected ':' for argument type.");
 
-            auto typeAttrs = _attribute();
-            auto type = _type_decl();
-            type->setChildVec("attributes", std::move(typeAttrs));
+            auto type = _attributed_type_decl("Expected argument type.");
 
-            auto ast = std::make_unique<AST>("arg");
+            auto ast = _arena.make<ArgNode>();
             ast->setName(name);
-            ast->setChildVec("attributes", std::move(argAttrs));
-            ast->setChild("type", std::move(type));
-            args.emplace_back(std::move(ast));
-        } while (_match(Token::Tokens["comma"]));
+            ast->attributes = _arena.copy(argAttrs);
+            ast->type = type;
+            args.emplace_back(ast);
+        } while (_match(TokenKind::Comma));
     }
 
-    _consume(Token::Tokens["paren_right"], "Expected ')' after function arguments.");
+    _consume(TokenKind::ParenRight, "Expected ')' after function arguments.");
 
-    std::unique_ptr<AST> _return = nullptr;
-    if (_match(Token::Tokens["arrow"])) {
-        auto attrs = _attribute();
-        _return = _type_decl();
-        _return->setChildVec("attributes", std::move(attrs));
-    }
-
-    auto body = _compound_statement();
+    TypeNode *_return = nullptr;
+    if (_match(TokenKind::Arrow))
+        _return = _attributed_type_decl("Expected return type.");
 
-    auto ast = std::make_unique<AST>("function");
+    auto ast = _arena.make<FunctionNode>();
     ast->setName(name);
-    ast->setChildVec("args", std::move(args));
-    ast->setChild("return", std::move(_return));
-    ast->setChild("body", std::move(body));
+    ast->args = _arena.copy(args);
+    ast->returnType = _return;
+    if (_mode == ParseMode::Declarations) {
+        _skip_compound_statement(ast);
+        return ast;
+    }
+
+    const auto &open = _peek();
+    ast->bodyOffset = open._offset;
+    ast->bodyLine = open._line;
+    ast->body = _compound_statement();
+    const auto &close = _previous();
+    ast->bodyLength = close._offset + close._length - ast->bodyOffset;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_compound_statement() {
+BlockNode *WgslParser::_compound_statement() {
     // brace_left statement* brace_right
-    std::vector<std::unique_ptr<AST>> statements{};
-    _consume(Token::Tokens["brace_left"], "Expected '{' for block.");
-    while (!_check(Token::Tokens["brace_right"])) {
+    _consume(TokenKind::BraceLeft, "Expected '{' for block.");
+    auto statements = _statement_list();
+    _consume(TokenKind::BraceRight, "Expected '}' for block.");
+
+    auto ast = _arena.make<BlockNode>();
+    ast->statements = _arena.copy(statements);
+    return ast;
+}
+
+void WgslParser::_skip_compound_statement(FunctionNode *function) {
+    // brace_left (any token, with matched braces)* brace_right
+    const auto &open = _consume(TokenKind::BraceLeft, "Expected '{' for block.");
+    function->bodyOffset = open._offset;
+    function->bodyLine = open._line;
+    size_t depth = 1;
+    while (!_isAtEnd()) {
+        const auto kind = _advance().kind();
+        if (kind == TokenKind::BraceLeft) {
+            depth++;
+        } else if (kind == TokenKind::BraceRight && --depth == 0) {
+            const auto &close = _previous();
+            function->bodyLength = close._offset + close._length - function->bodyOffset;
+            return;
+        }
+    }
+    _error(_peek(), "Expected '}' for block.");
+}
+
+std::vector<AST *> WgslParser::_statement_list() {
+    // statement*
+    std::vector<AST *> statements{};
+    while (!_isAtEnd() && !_check(kStatementListEnd)) {
+        const size_t start = _current;
         auto statement = _statement();
+        if (_panic) {
+            _synchronize(true);
+            if (_current == start)
+                _advance();
+            continue;
+        }
         if (statement)
-            statements.emplace_back(std::move(statement));
+            statements.emplace_back(statement);
     }
-    _consume(Token::Tokens["brace_right"], "Expected '}' for block.");
-
-    auto ast = std::make_unique<AST>("");
-    ast->setChildVec("", std::move(statements));
-    return ast;
+    return statements;
 }
 
-std::unique_ptr<AST> WgslParser::_statement() {
+AST *WgslParser::_statement() {
     // semicolon
     // return_statement semicolon
     // if_statement
@@ -246,94 +512,89 @@ std::unique_ptr<AST> WgslParser::_statement() {
     // compound_statement
 
     // Ignore any stand-alone semicolons
-    while (_match(Token::Tokens["semicolon"]) && !_isAtEnd());
+    while (_match(TokenKind::Semicolon) && !_isAtEnd());
 
-    if (_check(Token::Keywords["if"]))
+    if (_check(TokenKind::If))
         return _if_statement();
 
-    if (_check(Token::Keywords["switch"]))
+    if (_check(TokenKind::Switch))
         return _switch_statement();
 
-    if (_check(Token::Keywords["loop"]))
+    if (_check(TokenKind::Loop))
         return _loop_statement();
 
-    if (_check(Token::Keywords["for"]))
+    if (_check(TokenKind::For))
         return _for_statement();
 
-    if (_check(Token::Keywords["while"]))
+    if (_check(TokenKind::While))
         return _while_statement();
 
-    if (_check(Token::Tokens["brace_left"]))
+    if (_check(TokenKind::BraceLeft))
         return _compound_statement();
 
-    std::unique_ptr<AST> result = nullptr;
-    if (_check(Token::Keywords["return"]))
+    AST *result = nullptr;
+    if (_check(TokenKind::Return))
         result = _return_statement();
-    else if (_check({Token::Keywords["var"], Token::Keywords["let"]}))
+    else if (_check({TokenKind::Var, TokenKind::Let}))
         result = _variable_statement();
-    else if (_match(Token::Keywords["discard"])) {
-        result = std::make_unique<AST>("discard");
-    } else if (_match(Token::Keywords["break"])) {
-        result = std::make_unique<AST>("break");
-    } else if (_match(Token::Keywords["continue"])) {
-        result = std::make_unique<AST>("continue");
+    else if (_match(TokenKind::Discard)) {
+        result = _arena.make<AST>(NodeKind::Discard);
+    } else if (_match(TokenKind::Break)) {
+        result = _arena.make<AST>(NodeKind::Break);
+    } else if (_match(TokenKind::Continue)) {
+        result = _arena.make<AST>(NodeKind::Continue);
     } else {
-        auto state = _func_call_statement();
-        if (state) {
-            result = std::move(state);
-        }
-        state = _assignment_statement();
-        if (state) {
-            result = std::move(state);
-        }
+        result = _func_call_statement();
+        if (!result)
+            result = _assignment_statement();
     }
 
     if (result != nullptr)
-        _consume(Token::Tokens["semicolon"], "Expected ';' after statement.");
+        _consume(TokenKind::Semicolon, "Expected ';' after statement.");
 
     return result;
 }
 
-std::unique_ptr<AST> WgslParser::_while_statement() {
-    if (!_match(Token::Keywords["while"]))
+AST *WgslParser::_while_statement() {
+    if (!_match(TokenKind::While))
         return nullptr;
     auto condition = _optional_paren_expression();
     auto block = _compound_statement();
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("while");
-    ast->setChild("condition", std::move(condition));
-    ast->setChild("block", std::move(block));
+    auto ast = _arena.make<WhileNode>();
+    ast->condition = condition;
+    ast->block = block;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_for_statement() {
+AST *WgslParser::_for_statement() {
     // for paren_left for_header paren_right compound_statement
-    if (!_match(Token::Keywords["for"]))
+    if (!_match(TokenKind::For))
         return nullptr;
 
-    _consume(Token::Tokens["paren_left"], "Expected '('.");
+    _consume(TokenKind::ParenLeft, "Expected '('.");
 
     // for_header: (variable_statement assignment_statement func_call_statement)?
     // semicolon short_circuit_or_expression? semicolon (assignment_statement func_call_statement)?
-    auto init = !_check(Token::Tokens["semicolon"]) ? _for_init() : nullptr;
-    _consume(Token::Tokens["semicolon"], "Expected ';'.");
-    auto condition = !_check(Token::Tokens["semicolon"]) ? _short_circuit_or_expression() : nullptr;
-    _consume(Token::Tokens["semicolon"], "Expected ';'.");
-    auto increment = !_check(Token::Tokens["paren_right"]) ? _for_increment() : nullptr;
+    auto init = !_check(TokenKind::Semicolon) ? _for_init() : nullptr;
+    _consume(TokenKind::Semicolon, "Expected ';'.");
+    auto condition = !_check(TokenKind::Semicolon) ? _short_circuit_or_expression() : nullptr;
+    _consume(TokenKind::Semicolon, "Expected ';'.");
+    auto increment = !_check(TokenKind::ParenRight) ? _for_increment() : nullptr;
 
-    _consume(Token::Tokens["paren_right"], "Expected ')'.");
+    _consume(TokenKind::ParenRight, "Expected ')'.");
 
     auto body = _compound_statement();
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("for");
-    ast->setChild("init", std::move(init));
-    ast->setChild("condition", std::move(condition));
-    ast->setChild("increment", std::move(increment));
-    ast->setChild("body", std::move(body));
+    auto ast = _arena.make<ForNode>();
+    ast->init = init;
+    ast->condition = condition;
+    ast->increment = increment;
+    ast->body = body;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_for_init() {
+AST *WgslParser::_for_init() {
     // (variable_statement assignment_statement func_call_statement)?
     auto state = _variable_statement();
     if (state) {
@@ -352,7 +613,7 @@ std::unique_ptr<AST> WgslParser::_for_init() {
     return nullptr;
 }
 
-std::unique_ptr<AST> WgslParser::_for_increment() {
+AST *WgslParser::_for_increment() {
     // (assignment_statement func_call_statement)?
     auto state = _func_call_statement();
     if (state) {
@@ -366,36 +627,33 @@ std::unique_ptr<AST> WgslParser::_for_increment() {
     return nullptr;
 }
 
-std::unique_ptr<AST> WgslParser::_variable_statement() {
+AST *WgslParser::_variable_statement() {
     // variable_decl
     // variable_decl equal short_circuit_or_expression
     // let (ident variable_ident_decl) equal short_circuit_or_expression
-    if (_check(Token::Keywords["var"])) {
+    if (_check(TokenKind::Var)) {
         auto _var = _variable_decl();
-        std::unique_ptr<AST> value = nullptr;
-        if (_match(Token::Tokens["equal"]))
+        ExprNode *value = nullptr;
+        if (_match(TokenKind::Equal))
             value = _short_circuit_or_expression();
 
-        std::unique_ptr<AST> ast = std::make_unique<AST>("var");
-        ast->setChild("var", std::move(_var));
-        ast->setChild("value", std::move(value));
+        auto ast = _arena.make<VarStatementNode>();
+        ast->var = _var;
+        ast->value = value;
         return ast;
     }
 
-    if (_match(Token::Keywords["let"])) {
-        auto name = _consume(Token::Tokens["ident"], "Expected name for let.").toString();
-        std::unique_ptr<AST> type = nullptr;
-        if (_match(Token::Tokens["colon"])) {
-            auto typeAttrs = _attribute();
-            type = _type_decl();
-            type->setChildVec("attributes", std::move(typeAttrs));
-        }
-        _consume(Token::Tokens["equal"], "Expected '=' for let.");
+    if (_match(TokenKind::Let)) {
+        auto name = _symbol(_consume(TokenKind::Ident, "Expected name for let."));
+        TypeNode *type = nullptr;
+        if (_match(TokenKind::Colon))
+            type = _attributed_type_decl("Expected type for let.");
+        _consume(TokenKind::Equal, "Expected '=' for let.");
         auto value = _short_circuit_or_expression();
 
-        std::unique_ptr<AST> ast = std::make_unique<AST>("let");
-        ast->setChild("type", std::move(type));
-        ast->setChild("value", std::move(value));
+        auto ast = _arena.make<LetNode>();
+        ast->type = type;
+        ast->value = value;
         ast->setName(name);
         return ast;
     }
@@ -403,658 +661,507 @@ std::unique_ptr<AST> WgslParser::_variable_statement() {
     return nullptr;
 }
 
-std::unique_ptr<AST> WgslParser::_assignment_statement() {
+AST *WgslParser::_assignment_statement() {
     // (unary_expression underscore) equal short_circuit_or_expression
-    std::unique_ptr<AST> _var = nullptr;
+    ExprNode *_var = nullptr;
 
-    if (_check(Token::Tokens["brace_right"]))
+    if (_check(TokenKind::BraceRight))
         return nullptr;
 
-    auto isUnderscore = _match(Token::Tokens["underscore"]);
+    auto isUnderscore = _match(TokenKind::Underscore);
     if (!isUnderscore)
         _var = _unary_expression();
 
     if (!isUnderscore && _var == nullptr)
         return nullptr;
 
-    _consume(Token::Tokens["equal"], "Expected '='.");
+    _consume(TokenKind::Equal, "Expected '='.");
 
     auto value = _short_circuit_or_expression();
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("assign");
-    ast->setChild("var", std::move(_var));
-    ast->setChild("value", std::move(value));
+    auto ast = _arena.make<AssignNode>();
+    ast->var = _var;
+    ast->value = value;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_func_call_statement() {
+AST *WgslParser::_func_call_statement() {
     // ident argument_expression_list
-    if (!_check(Token::Tokens["ident"]))
+    if (!_check(TokenKind::Ident))
         return nullptr;
 
+    // Without a '(' after the name this is an assignment; backtracking is limited to that
+    // one token.
     auto savedPos = _current;
-    auto name = _consume(Token::Tokens["ident"], "Expected function name.");
-    auto args = _argument_expression_list();
-
-    if (args.empty()) {
+    auto name = _consume(TokenKind::Ident, "Expected function name.");
+    if (!_check(TokenKind::ParenLeft)) {
         _current = savedPos;
         return nullptr;
     }
+    auto args = _argument_expression_list();
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("call");
-    ast->setChildVec("args", std::move(args));
-    ast->setName(name._type.name);
+    auto ast = _arena.make<CallNode>();
+    ast->args = _arena.copy(args);
+    ast->setName(_symbol(name));
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_loop_statement() {
+AST *WgslParser::_loop_statement() {
     // loop brace_left statement* continuing_statement? brace_right
-    if (!_match(Token::Keywords["loop"]))
+    if (!_match(TokenKind::Loop))
         return nullptr;
 
-    _consume(Token::Tokens["brace_left"], "Expected '{' for loop.");
+    _consume(TokenKind::BraceLeft, "Expected '{' for loop.");
 
-    // statement*
-    std::vector<std::unique_ptr<AST>> statements{};
-    auto statement = _statement();
-    while (statement != nullptr) {
-        statements.emplace_back(std::move(statement));
-        statement = _statement();
-    }
+    auto statements = _statement_list();
 
     // continuing_statement: continuing compound_statement
-    std::unique_ptr<AST> continuing = nullptr;
-    if (_match(Token::Keywords["continuing"]))
+    BlockNode *continuing = nullptr;
+    if (_match(TokenKind::Continuing))
         continuing = _compound_statement();
 
-    _consume(Token::Tokens["brace_right"], "Expected '}' for loop.");
+    _consume(TokenKind::BraceRight, "Expected '}' for loop.");
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("loop");
-    ast->setChildVec("statements", std::move(statements));
-    ast->setChild("continuing", std::move(continuing));
+    auto ast = _arena.make<LoopNode>();
+    ast->statements = _arena.copy(statements);
+    ast->continuing = continuing;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_switch_statement() {
+AST *WgslParser::_switch_statement() {
     // switch optional_paren_expression brace_left switch_body+ brace_right
-    if (!_match(Token::Keywords["switch"]))
+    if (!_match(TokenKind::Switch))
         return nullptr;
 
     auto condition = _optional_paren_expression();
-    _consume(Token::Tokens["brace_left"], "");
+    _consume(TokenKind::BraceLeft, "Expected '{' for switch.");
     auto body = _switch_body();
     if (body.empty())
-        throw std::runtime_error("Expected 'case' or 'default'.");
-    _consume(Token::Tokens["brace_right"], "");
+        _error(_peek(), "Expected 'case' or 'default'.");
+    _consume(TokenKind::BraceRight, "Expected '}' for switch.");
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("switch");
-    ast->setChildVec("body", std::move(body));
-    ast->setChild("condition", std::move(condition));
+    auto ast = _arena.make<SwitchNode>();
+    ast->body = _arena.copy(body);
+    ast->condition = condition;
     return ast;
 }
 
-std::vector<std::unique_ptr<AST>> WgslParser::_switch_body() {
+std::vector<AST *> WgslParser::_switch_body() {
     // case case_selectors colon brace_left case_body? brace_right
     // default colon brace_left case_body? brace_right
-    std::vector<std::unique_ptr<AST>> cases{};
-    if (_match(Token::Keywords["case"])) {
-        _consume(Token::Keywords["case"], "");
+    std::vector<AST *> cases{};
+    if (_match(TokenKind::Case)) {
         auto selector = _case_selectors();
-        _consume(Token::Keywords["colon"], "Exected ':' for switch case.");
-        _consume(Token::Tokens["brace_left"], "Exected '{' for switch case.");
+        _consume(TokenKind::Colon, "Exected ':' for switch case.");
+        _consume(TokenKind::BraceLeft, "Exected '{' for switch case.");
         auto body = _case_body();
-        _consume(Token::Tokens["brace_right"], "Exected '}' for switch case.");
+        _consume(TokenKind::BraceRight, "Exected '}' for switch case.");
 
-        std::unique_ptr<AST> ast = std::make_unique<AST>("case");
-        ast->setChildVec("body", std::move(body));
-        ast->setNameVec("selector", selector);
-        cases.emplace_back(std::move(ast));
+        auto ast = _arena.make<CaseNode>(NodeKind::Case);
+        ast->body = _arena.copy(body);
+        ast->selectors = _arena.copy(selector);
+        cases.emplace_back(ast);
     }
 
-    if (_match(Token::Keywords["default"])) {
-        _consume(Token::Tokens["colon"], "Exected ':' for switch default.");
-        _consume(Token::Tokens["brace_left"], "Exected '{' for switch default.");
+    if (_match(TokenKind::Default)) {
+        _consume(TokenKind::Colon, "Exected ':' for switch default.");
+        _consume(TokenKind::BraceLeft, "Exected '{' for switch default.");
         auto body = _case_body();
-        _consume(Token::Tokens["brace_right"], "Exected '}' for switch default.");
+        _consume(TokenKind::BraceRight, "Exected '}' for switch default.");
 
-        std::unique_ptr<AST> ast = std::make_unique<AST>("default");
-        ast->setChildVec("body", std::move(body));
-        cases.emplace_back(std::move(ast));
+        auto ast = _arena.make<CaseNode>(NodeKind::Default);
+        ast->body = _arena.copy(body);
+        cases.emplace_back(ast);
     }
 
-    if (_check({Token::Keywords["default"], Token::Keywords["case"]})) {
+    if (_check({TokenKind::Default, TokenKind::Case})) {
         auto _cases = _switch_body();
-        cases.emplace_back(std::move(_cases[0]));
+        cases.emplace_back(_cases[0]);
     }
 
     return cases;
 }
 
-std::vector<std::string> WgslParser::_case_selectors() {
+std::vector<std::string_view> WgslParser::_case_selectors() {
     // const_literal (comma const_literal)* comma?
-    std::vector<std::string> selectors = {
-            _consume(Token::Tokens["const_literal"], "Expected constant literal").toString()};
-    while (_match(Token::Tokens["comma"])) {
-        selectors.push_back(_consume(Token::Tokens["const_literal"], "Expected constant literal").toString());
+    std::vector<std::string_view> selectors = {
+            _arena.copy(_consume(Token::ConstLiteral, "Expected constant literal").lexeme(_source))};
+    while (_match(TokenKind::Comma)) {
+        selectors.push_back(_arena.copy(_consume(Token::ConstLiteral, "Expected constant literal").lexeme(_source)));
     }
     return selectors;
 }
 
-std::vector<std::unique_ptr<AST>> WgslParser::_case_body() {
-    // statement case_body?
-    // fallthrough semicolon
-    if (_match(Token::Keywords["fallthrough"])) {
-        _consume(Token::Tokens["semicolon"], "");
-        return {};
-    }
-
-    auto statement = _statement();
-    if (statement == nullptr)
-        return {};
-
-    auto nextStatement = _case_body();
-    if (nextStatement.empty()) {
-        std::vector<std::unique_ptr<AST>> result(1);
-        result[0] = std::move(statement);
-        return result;
-    }
-
-    std::vector<std::unique_ptr<AST>> result(2);
-    result[0] = std::move(statement);
-    result[1] = std::move(nextStatement[0]);
-    return result;
+std::vector<AST *> WgslParser::_case_body() {
+    // statement* (fallthrough semicolon)?
+    auto statements = _statement_list();
+    if (_match(TokenKind::Fallthrough))
+        _consume(TokenKind::Semicolon, "Expected ';' after fallthrough.");
+    return statements;
 }
 
-std::unique_ptr<AST> WgslParser::_if_statement() {
+AST *WgslParser::_if_statement() {
     // if optional_paren_expression compound_statement elseif_statement? else_statement?
-    if (!_match(Token::Keywords["if"]))
+    if (!_match(TokenKind::If))
         return nullptr;
 
     auto condition = _optional_paren_expression();
     auto block = _compound_statement();
 
-    std::vector<std::unique_ptr<AST>> elseif{};
-    if (_match(Token::Keywords["elseif"]))
+    std::vector<AST *> elseif{};
+    if (_match(TokenKind::Elseif))
         elseif = _elseif_statement();
 
-    std::unique_ptr<AST> _else = nullptr;
-    if (_match(Token::Keywords["else"]))
+    BlockNode *_else = nullptr;
+    if (_match(TokenKind::Else))
         _else = _compound_statement();
 
-    std::unique_ptr<AST> ast = std::make_unique<AST>("if");
-    ast->setChild("condition", std::move(condition));
-    ast->setChild("block", std::move(block));
-    ast->setChildVec("elseif", std::move(elseif));
-    ast->setChild("else", std::move(_else));
+    auto ast = _arena.make<IfNode>(NodeKind::If);
+    ast->condition = condition;
+    ast->block = block;
+    ast->elseif = _arena.copy(elseif);
+    ast->elseBlock = _else;
     return ast;
 }
 
-std::vector<std::unique_ptr<AST>> WgslParser::_elseif_statement() {
+std::vector<AST *> WgslParser::_elseif_statement() {
     // else_if optional_paren_expression compound_statement elseif_statement?
-    std::vector<std::unique_ptr<AST>> elseif{};
+    std::vector<AST *> elseif{};
     auto condition = _optional_paren_expression();
     auto block = _compound_statement();
-    auto ast = std::make_unique<AST>("elseif");
-    ast->setChild("condition", std::move(condition));
-    ast->setChild("block", std::move(block));
-    elseif.emplace_back(std::move(ast));
-    if (_match(Token::Keywords["elseif"]))
-        elseif.emplace_back(std::move(_elseif_statement()[0]));
+    auto ast = _arena.make<IfNode>(NodeKind::ElseIf);
+    ast->condition = condition;
+    ast->block = block;
+    elseif.emplace_back(ast);
+    if (_match(TokenKind::Elseif))
+        elseif.emplace_back(_elseif_statement()[0]);
     return elseif;
 }
 
-std::unique_ptr<AST> WgslParser::_return_statement() {
+AST *WgslParser::_return_statement() {
     // return short_circuit_or_expression?
-    if (!_match(Token::Keywords["return"]))
+    if (!_match(TokenKind::Return))
         return nullptr;
     auto value = _short_circuit_or_expression();
 
-    auto ast = std::make_unique<AST>("return");
-    ast->setChild("value", std::move(value));
+    auto ast = _arena.make<ReturnNode>();
+    ast->value = value;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_short_circuit_or_expression() {
-    // short_circuit_and_expression
-    // short_circuit_or_expression or_or short_circuit_and_expression
-    auto expr = _short_circuit_and_expr();
-    while (_match(Token::Tokens["or_or"])) {
-        auto ast = std::make_unique<AST>("compareOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", std::move(_short_circuit_and_expr()));
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_short_circuit_and_expr() {
-    // inclusive_or_expression
-    // short_circuit_and_expression and_and inclusive_or_expression
-    auto expr = _inclusive_or_expression();
-    while (_match(Token::Tokens["and_and"])) {
-        auto ast = std::make_unique<AST>("compareOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _inclusive_or_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_inclusive_or_expression() {
-    // exclusive_or_expression
-    // inclusive_or_expression or exclusive_or_expression
-    auto expr = _exclusive_or_expression();
-    while (_match(Token::Tokens["or"])) {
-        auto ast = std::make_unique<AST>("binaryOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _exclusive_or_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_exclusive_or_expression() {
-    // and_expression
-    // exclusive_or_expression xor and_expression
-    auto expr = _and_expression();
-    while (_match(Token::Tokens["xor"])) {
-        auto ast = std::make_unique<AST>("binaryOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _and_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_and_expression() {
-    // equality_expression
-    // and_expression and equality_expression
-    auto expr = _equality_expression();
-    while (_match(Token::Tokens["and"])) {
-        auto ast = std::make_unique<AST>("binaryOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _equality_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_equality_expression() {
-    // relational_expression
-    // relational_expression equal_equal relational_expression
-    // relational_expression not_equal relational_expression
-    auto expr = _relational_expression();
-    if (_match({Token::Tokens["equal_equal"], Token::Tokens["not_equal"]})) {
-        auto ast = std::make_unique<AST>("compareOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _relational_expression());
-        ast->setName(_previous().toString());
-        return ast;
-    }
-    return expr;
+ExprNode *WgslParser::_short_circuit_or_expression() {
+    return _binary_expression(1, UINT8_MAX);
 }
 
-std::unique_ptr<AST> WgslParser::_relational_expression() {
-    // shift_expression
-    // relational_expression less_than shift_expression
-    // relational_expression greater_than shift_expression
-    // relational_expression less_than_equal shift_expression
-    // relational_expression greater_than_equal shift_expression
-    auto expr = _shift_expression();
-    while (_match({Token::Tokens["less_than"], Token::Tokens["greater_than"],
-                   Token::Tokens["less_than_equal"], Token::Tokens["greater_than_equal"]})) {
-        auto ast = std::make_unique<AST>("compareOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _shift_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_shift_expression() {
-    // additive_expression
-    // shift_expression shift_left additive_expression
-    // shift_expression shift_right additive_expression
-    auto expr = _additive_expression();
-    while (_match({Token::Tokens["shift_left"], Token::Tokens["shift_right"]})) {
-        auto ast = std::make_unique<AST>("binaryOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _additive_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_additive_expression() {
-    // multiplicative_expression
-    // additive_expression plus multiplicative_expression
-    // additive_expression minus multiplicative_expression
-    auto expr = _multiplicative_expression();
-    while (_match({Token::Tokens["plus"], Token::Tokens["minus"]})) {
-        auto ast = std::make_unique<AST>("binaryOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _multiplicative_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
-    }
-    return expr;
-}
-
-std::unique_ptr<AST> WgslParser::_multiplicative_expression() {
-    // unary_expression
-    // multiplicative_expression star unary_expression
-    // multiplicative_expression forward_slash unary_expression
-    // multiplicative_expression modulo unary_expression
+ExprNode *WgslParser::_binary_expression(uint8_t minPrecedence, uint8_t maxPrecedence) {
+    // unary_expression (binary_operator unary_expression)*
+    // Parses the operators of kBinaryOperators that bind at least as tight as minPrecedence by
+    // precedence climbing: the operand to the right of an operator takes all the operators
+    // that bind tighter than it.
     auto expr = _unary_expression();
-    while (_match({Token::Tokens["star"], Token::Tokens["forward_slash"], Token::Tokens["modulo"]})) {
-        auto ast = std::make_unique<AST>("binaryOp");
-        ast->setChild("left", std::move(expr));
-        ast->setChild("right", _unary_expression());
-        ast->setName(_previous().toString());
-        expr = std::move(ast);
+    while (!_isAtEnd()) {
+        const auto op = kBinaryOperators[static_cast<size_t>(_peek().kind())];
+        if (op.precedence < minPrecedence || op.precedence > maxPrecedence)
+            break;
+        auto ast = _arena.make<BinaryOpNode>(op.kind);
+        ast->setName(_symbol(_advance()));
+        ast->left = expr;
+        ast->right = _binary_expression(op.precedence + 1, UINT8_MAX);
+        expr = ast;
+        // What follows has to bind looser than op, or as tight for a left associative op.
+        // Equality doesn't chain: a == b == c is an error.
+        maxPrecedence = op.precedence == kEqualityPrecedence ? op.precedence - 1 : op.precedence;
     }
     return expr;
 }
 
-std::unique_ptr<AST> WgslParser::_unary_expression() {
+ExprNode *WgslParser::_unary_expression() {
     // singular_expression
     // minus unary_expression
     // bang unary_expression
     // tilde unary_expression
     // star unary_expression
     // and unary_expression
-    if (_match({Token::Tokens["minus"], Token::Tokens["bang"],
-                Token::Tokens["tilde"], Token::Tokens["star"], Token::Tokens["and"]})) {
-        auto ast = std::make_unique<AST>("unaryOp");
-        ast->setChild("right", _unary_expression());
-        ast->setName(_previous().toString());
+    if (_match(kUnaryOperators)) {
+        auto ast = _arena.make<UnaryOpNode>();
+        ast->setName(_symbol(_previous()));
+        ast->right = _unary_expression();
         return ast;
     }
     return _singular_expression();
 }
 
-std::unique_ptr<AST> WgslParser::_singular_expression() {
+ExprNode *WgslParser::_singular_expression() {
     // primary_expression postfix_expression ?
     auto expr = _primary_expression();
     auto p = _postfix_expression();
     if (p)
-        expr->setChild("postfix", std::move(p));
+        expr->postfix = p;
     return expr;
 }
 
-std::unique_ptr<AST> WgslParser::_postfix_expression() {
+ExprNode *WgslParser::_postfix_expression() {
     // bracket_left short_circuit_or_expression bracket_right postfix_expression?
-    if (_match(Token::Tokens["bracket_left"])) {
+    if (_match(TokenKind::BracketLeft)) {
         auto expr = _short_circuit_or_expression();
-        _consume(Token::Tokens["bracket_right"], "Expected ']'.");
+        _consume(TokenKind::BracketRight, "Expected ']'.");
         auto p = _postfix_expression();
         if (p)
-            expr->setChild("postfix", std::move(p));
+            expr->postfix = p;
         return expr;
     }
 
     // period ident postfix_expression?
-//    if (_match(Token::Tokens["period"])) {
-//        auto name = _consume(Token::Tokens["ident"], "Expected member name.");
-//        auto p = _postfix_expression();
-//        if (p)
-//            name.postfix = p;
-//        return name;
-//    }
+    if (_match(TokenKind::Period)) {
+        auto ast = _arena.make<ExprNode>(NodeKind::VariableExpr);
+        ast->setName(_symbol(_consume(TokenKind::Ident, "Expected member name.")));
+        auto p = _postfix_expression();
+        if (p)
+            ast->postfix = p;
+        return ast;
+    }
 
     return nullptr;
 }
 
-std::unique_ptr<AST> WgslParser::_primary_expression() {
+ExprNode *WgslParser::_primary_expression() {
     // ident argument_expression_list?
-    if (_match(Token::Tokens["ident"])) {
-        auto name = _previous().toString();
-        if (_check(Token::Tokens["paren_left"])) {
+    if (_match(TokenKind::Ident)) {
+        auto name = _symbol(_previous());
+        if (_check(TokenKind::ParenLeft)) {
             auto args = _argument_expression_list();
 
-            auto ast = std::make_unique<AST>("call_expr");
+            auto ast = _arena.make<CallExprNode>();
             ast->setName(name);
-            ast->setChildVec("args", std::move(args));
+            ast->args = _arena.copy(args);
             return ast;
         }
-        auto ast = std::make_unique<AST>("variable_expr");
+        auto ast = _arena.make<ExprNode>(NodeKind::VariableExpr);
         ast->setName(name);
         return ast;
     }
 
     // const_literal
-    if (_match(Token::Tokens["const_literal"])) {
-        auto ast = std::make_unique<AST>("literal_expr");
-        ast->setName(_previous().toString());
+    if (_match(Token::ConstLiteral)) {
+        auto ast = _arena.make<ExprNode>(NodeKind::LiteralExpr);
+        ast->setName(_symbol(_previous()));
+        return ast;
     }
 
     // paren_expression
-    if (_check(Token::Tokens["paren_left"])) {
+    if (_check(TokenKind::ParenLeft)) {
         return _paren_expression();
     }
 
     // bitcast less_than type_decl greater_than paren_expression
-    if (_match(Token::Keywords["bitcast"])) {
-        _consume(Token::Tokens["less_than"], "Expected '<'.");
+    if (_match(TokenKind::Bitcast)) {
+        _consume(TokenKind::LessThan, "Expected '<'.");
         auto type = _type_decl();
-        _consume(Token::Tokens["greater_than"], "Expected '>'.");
+        _consume(TokenKind::GreaterThan, "Expected '>'.");
         auto value = _paren_expression();
 
-        auto ast = std::make_unique<AST>("bitcast_expr");
-        ast->setChild("type", std::move(type));
-        ast->setChild("value", std::move(value));
+        auto ast = _arena.make<CastExprNode>(NodeKind::BitcastExpr);
+        ast->type = type;
+        ast->value = value;
         return ast;
     }
 
     // type_decl argument_expression_list
     auto type = _type_decl();
+    if (!type)
+        _error(_peek(), "Expected expression.");
     auto args = _argument_expression_list();
 
-    auto ast = std::make_unique<AST>("typecast_expr");
-    ast->setChild("type", std::move(type));
-    ast->setChildVec("args", std::move(args));
+    auto ast = _arena.make<CastExprNode>(NodeKind::TypecastExpr);
+    ast->type = type;
+    ast->args = _arena.copy(args);
     return ast;
 }
 
-std::vector<std::unique_ptr<AST>> WgslParser::_argument_expression_list() {
+std::vector<AST *> WgslParser::_argument_expression_list() {
     // paren_left ((short_circuit_or_expression comma)* short_circuit_or_expression comma?)? paren_right
-    if (!_match(Token::Tokens["paren_left"]))
+    if (!_match(TokenKind::ParenLeft))
         return {};
 
-    std::vector<std::unique_ptr<AST>> args{};
+    std::vector<AST *> args{};
     do {
-        if (_check(Token::Tokens["paren_right"]))
+        if (_check(TokenKind::ParenRight))
             break;
         auto arg = _short_circuit_or_expression();
-        args.emplace_back(std::move(arg));
-    } while (_match(Token::Tokens["comma"]));
-    _consume(Token::Tokens["paren_right"], "Expected ')' for agument list");
+        args.emplace_back(arg);
+    } while (_match(TokenKind::Comma));
+    _consume(TokenKind::ParenRight, "Expected ')' for agument list");
 
     return args;
 }
 
-std::unique_ptr<AST> WgslParser::_optional_paren_expression() {
+GroupingExprNode *WgslParser::_optional_paren_expression() {
     // [paren_left] short_circuit_or_expression [paren_right]
-    _match(Token::Tokens["paren_left"]);
+    _match(TokenKind::ParenLeft);
     auto expr = _short_circuit_or_expression();
-    _match(Token::Tokens["paren_right"]);
+    _match(TokenKind::ParenRight);
 
-    auto ast = std::make_unique<AST>("grouping_expr");
-    ast->setChild("expr", std::move(expr));
+    auto ast = _arena.make<GroupingExprNode>();
+    ast->expr = expr;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_paren_expression() {
+GroupingExprNode *WgslParser::_paren_expression() {
     // paren_left short_circuit_or_expression paren_right
-    _consume(Token::Tokens["paren_left"], "Expected '('.");
+    _consume(TokenKind::ParenLeft, "Expected '('.");
     auto expr = _short_circuit_or_expression();
-    _consume(Token::Tokens["paren_right"], "Expected ')'.");
+    _consume(TokenKind::ParenRight, "Expected ')'.");
 
-    auto ast = std::make_unique<AST>("grouping_expr");
-    ast->setChild("contents", std::move(expr));
+    auto ast = _arena.make<GroupingExprNode>();
+    ast->expr = expr;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_struct_decl() {
+StructNode *WgslParser::_struct_decl() {
     // attribute* struct ident struct_body_decl
-    if (!_match(Token::Keywords["struct"]))
+    if (!_match(TokenKind::Struct))
         return nullptr;
 
-    auto name = _consume(Token::Tokens["ident"], "Expected name for struct.").toString();
+    auto name = _symbol(_consume(TokenKind::Ident, "Expected name for struct."));
 
     // struct_body_decl: brace_left (struct_member comma)* struct_member comma? brace_right
-    _consume(Token::Tokens["brace_left"], "Expected '{' for struct body.");
-    std::vector<std::unique_ptr<AST>> members{};
-    while (!_check(Token::Tokens["brace_right"])) {
+    _consume(TokenKind::BraceLeft, "Expected '{' for struct body.");
+    std::vector<AST *> members{};
+    while (!_isAtEnd() && !_check(TokenKind::BraceRight)) {
         // struct_member: attribute* variable_ident_decl
         auto memberAttrs = _attribute();
 
-        auto memberName = _consume(Token::Tokens["ident"], "Expected variable name.").toString();
+        auto memberName = _symbol(_consume(TokenKind::Ident, "Expected variable name."));
 
-        _consume(Token::Tokens["colon"], "Expected ':' for struct member type.");
+        _consume(TokenKind::Colon, "Expected ':' for struct member type.");
 
-        auto typeAttrs = _attribute();
-        auto memberType = _type_decl();
-        memberType->setChildVec("attributes", std::move(typeAttrs));
+        auto memberType = _attributed_type_decl("Expected type for struct member.");
 
-        if (!_check(Token::Tokens["brace_right"]))
-            _consume(Token::Tokens["comma"], "Expected ',' for struct member.");
+        if (!_check(TokenKind::BraceRight))
+            _consume(TokenKind::Comma, "Expected ',' for struct member.");
         else
-            _match(Token::Tokens["comma"]); // trailing comma optional.
+            _match(TokenKind::Comma); // trailing comma optional.
 
-        auto ast = std::make_unique<AST>("member");
-        ast->setChildVec("attributes", std::move(memberAttrs));
-        ast->setChild("type", std::move(memberType));
+        auto ast = _arena.make<MemberNode>();
+        ast->attributes = _arena.copy(memberAttrs);
+        ast->type = memberType;
         ast->setName(memberName);
-        members.emplace_back(std::move(ast));
+        members.emplace_back(ast);
     }
 
-    _consume(Token::Tokens["brace_right"], "Expected '}' after struct body.");
+    _consume(TokenKind::BraceRight, "Expected '}' after struct body.");
 
-    auto ast = std::make_unique<AST>("struct");
-    ast->setChildVec("members", std::move(members));
+    auto ast = _arena.make<StructNode>();
+    ast->members = _arena.copy(members);
     ast->setName(name);
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_global_variable_decl() {
+VarNode *WgslParser::_global_variable_decl() {
     // attribute* variable_decl (equal const_expression)?
     auto _var = _variable_decl();
-    if (_match(Token::Tokens["equal"]))
-        _var->setChild("value", _const_expression());
+    if (_match(TokenKind::Equal))
+        _var->value = _const_expression();
     return _var;
 }
 
-std::unique_ptr<AST> WgslParser::_global_constant_decl() {
+LetNode *WgslParser::_global_constant_decl() {
     // attribute* let (ident variable_ident_decl) global_const_initializer?
-    if (!_match(Token::Keywords["let"]))
+    if (!_match(TokenKind::Let))
         return nullptr;
 
-    auto name = _consume(Token::Tokens["ident"], "Expected variable name");
-    std::unique_ptr<AST> type = nullptr;
-    if (_match(Token::Tokens["colon"])) {
-        auto attrs = _attribute();
-        type = _type_decl();
-        type->setChildVec("attributes", std::move(attrs));
-    }
-    std::unique_ptr<AST> value = nullptr;
-    if (_match(Token::Tokens["equal"])) {
+    auto name = _consume(TokenKind::Ident, "Expected variable name");
+    TypeNode *type = nullptr;
+    if (_match(TokenKind::Colon))
+        type = _attributed_type_decl("Expected type for let.");
+    CreateNode *value = nullptr;
+    if (_match(TokenKind::Equal)) {
         value = _const_expression();
     }
 
-    auto ast = std::make_unique<AST>("let");
-    ast->setChild("type", std::move(type));
-    ast->setChild("value", std::move(value));
-    ast->setName(name.toString());
+    auto ast = _arena.make<LetNode>();
+    ast->type = type;
+    ast->value = value;
+    ast->setName(_symbol(name));
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_const_expression() {
+CreateNode *WgslParser::_const_expression() {
     // type_decl paren_left ((const_expression comma)* const_expression comma?)? paren_right
     // const_literal
-//    if (_match(Token::Tokens["const_literal"]))
-//        return _previous().toString();
+//    if (_match(Token::ConstLiteral))
+//        return _previous().toString(_source);
 
     auto type = _type_decl();
 
-    _consume(Token::Tokens["paren_left"], "Expected '('.");
+    _consume(TokenKind::ParenLeft, "Expected '('.");
 
-    std::vector<std::unique_ptr<AST>> args{};
-    while (!_check(Token::Tokens["paren_right"])) {
+    std::vector<AST *> args{};
+    while (!_isAtEnd() && !_check(TokenKind::ParenRight)) {
         args.emplace_back(_const_expression());
-        if (!_check(Token::Tokens["comma"]))
+        if (!_check(TokenKind::Comma))
             break;
         _advance();
     }
 
-    _consume(Token::Tokens["paren_right"], "Expected ')'.");
+    _consume(TokenKind::ParenRight, "Expected ')'.");
 
-    auto ast = std::make_unique<AST>("create");
-    ast->setChild("type", std::move(type));
-    ast->setChildVec("args", std::move(args));
+    auto ast = _arena.make<CreateNode>();
+    ast->type = type;
+    ast->args = _arena.copy(args);
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_variable_decl() {
+VarNode *WgslParser::_variable_decl() {
     // var variable_qualifier? (ident variable_ident_decl)
-    if (!_match(Token::Keywords["var"]))
+    if (!_match(TokenKind::Var))
         return nullptr;
 
     // variable_qualifier: less_than storage_class (comma access_mode)? greater_than
-    std::string storage;
-    std::string access;
-    if (_match(Token::Tokens["less_than"])) {
-        storage = _consume(Token::Tokens["storage_class"], "Expected storage_class.").toString();
-        if (_match(Token::Tokens["comma"]))
-            access = _consume(Token::Tokens["access_mode"], "Expected access_mode.").toString();
-        _consume(Token::Tokens["greater_than"], "Expected '>'.");
+    std::string_view storage;
+    std::string_view access;
+    if (_match(TokenKind::LessThan)) {
+        storage = _consume(Token::StorageClass, "Expected storage_class.").lexeme(_source);
+        if (_match(TokenKind::Comma))
+            access = _consume(Token::AccessMode, "Expected access_mode.").lexeme(_source);
+        _consume(TokenKind::GreaterThan, "Expected '>'.");
     }
 
-    auto name = _consume(Token::Tokens["ident"], "Expected variable name");
-    std::unique_ptr<AST> type = nullptr;
-    if (_match(Token::Tokens["colon"])) {
-        auto attrs = _attribute();
-        type = _type_decl();
-        type->setChildVec("attributes", std::move(attrs));
-    }
+    auto name = _consume(TokenKind::Ident, "Expected variable name");
+    TypeNode *type = nullptr;
+    if (_match(TokenKind::Colon))
+        type = _attributed_type_decl("Expected type for variable.");
 
-    auto ast = std::make_unique<AST>("var");
-    ast->setChild("type", std::move(type));
-    ast->setNameVec("storage", {storage});
-    ast->setNameVec("access", {access});
-    ast->setName(name.toString());
+    auto ast = _arena.make<VarNode>();
+    ast->type = type;
+    ast->storage = _arena.copy(storage);
+    ast->access = _arena.copy(access);
+    ast->setName(_symbol(name));
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_enable_directive() {
+AST *WgslParser::_enable_directive() {
     // enable ident semicolon
-    auto name = _consume(Token::Tokens["ident"], "identity expected.");
+    auto name = _consume(TokenKind::Ident, "identity expected.");
 
-    auto ast = std::make_unique<AST>("enable");
-    ast->setName(name.toString());
+    auto ast = _arena.make<AST>(NodeKind::Enable);
+    ast->setName(_symbol(name));
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_type_alias() {
+AST *WgslParser::_type_alias() {
     // type ident equal type_decl
-    auto name = _consume(Token::Tokens["ident"], "identity expected.");
-    _consume(Token::Tokens["equal"], "Expected '=' for type alias.");
+    auto name = _consume(TokenKind::Ident, "identity expected.");
+    _consume(TokenKind::Equal, "Expected '=' for type alias.");
     auto alias = _type_decl();
 
-    auto ast = std::make_unique<AST>("alias");
-    ast->setName(name.toString());
-    ast->setChild("alias", std::move(alias));
+    auto ast = _arena.make<AliasNode>();
+    ast->setName(_symbol(name));
+    ast->alias = alias;
     return ast;
 }
 
-std::unique_ptr<AST> WgslParser::_type_decl() {
+TypeNode *WgslParser::_type_decl() {
     // ident
     // bool
     // float32
@@ -1077,44 +1184,48 @@ std::unique_ptr<AST> WgslParser::_type_decl() {
     // array_type_decl
     // texture_sampler_types
 
-    if (_check({Token::Tokens["ident"], Token::Tokens["texel_format"],
-                Token::Keywords["bool"], Token::Keywords["float32"],
-                Token::Keywords["int32"], Token::Keywords["uint32"]})) {
+    if (_check({TokenKind::Ident, TokenKind::Bool, TokenKind::F32,
+                TokenKind::I32, TokenKind::U32}) ||
+        _check(Token::TexelFormat)) {
         auto type = _advance();
 
-        auto ast = std::make_unique<AST>("type");
-        ast->setName(type.toString());
+        auto ast = _arena.make<TypeNode>(NodeKind::Type);
+        ast->setName(_symbol(type));
         return ast;
     }
 
-    if (_check(Token::Tokens["template_types"])) {
-        auto type = _advance().toString();
-        _consume(Token::Tokens["less_than"], "Expected '<' for type.");
+    if (_check(Token::TemplateTypes)) {
+        auto type = _symbol(_advance());
+        _consume(TokenKind::LessThan, "Expected '<' for type.");
         auto format = _type_decl();
-        if (_match(Token::Tokens["comma"]))
-            _consume(Token::Tokens["access_mode"], "Expected access_mode for pointer").toString();
-        _consume(Token::Tokens["greater_than"], "Expected '>' for type.");
+        std::string_view access;
+        if (_match(TokenKind::Comma))
+            access = _consume(Token::AccessMode, "Expected access_mode for pointer").lexeme(_source);
+        _consume(TokenKind::GreaterThan, "Expected '>' for type.");
 
-        auto ast = std::make_unique<AST>("type");
+        auto ast = _arena.make<TypeNode>(NodeKind::Type);
         ast->setName(type);
-        ast->setChild("format", std::move(format));
+        ast->format = format;
+        ast->access = _arena.copy(access);
         return ast;
     }
 
     // pointer less_than storage_class comma type_decl (comma access_mode)? greater_than
-    if (_match(Token::Keywords["pointer"])) {
-        auto pointer = _previous().toString();
-        _consume(Token::Tokens["less_than"], "Expected '<' for pointer.");
-        auto storage = _consume(Token::Tokens["storage_class"], "Expected storage_class for pointer");
-        _consume(Token::Tokens["comma"], "Expected ',' for pointer.");
+    if (_match(TokenKind::Ptr)) {
+        auto pointer = _symbol(_previous());
+        _consume(TokenKind::LessThan, "Expected '<' for pointer.");
+        auto storage = _consume(Token::StorageClass, "Expected storage_class for pointer");
+        _consume(TokenKind::Comma, "Expected ',' for pointer.");
         auto decl = _type_decl();
-        if (_match(Token::Tokens["comma"]))
-            _consume(Token::Tokens["access_mode"], "Expected access_mode for pointer").toString();
-        _consume(Token::Tokens["greater_than"], "Expected '>' for pointer.");
+        std::string_view access;
+        if (_match(TokenKind::Comma))
+            access = _consume(Token::AccessMode, "Expected access_mode for pointer").lexeme(_source);
+        _consume(TokenKind::GreaterThan, "Expected '>' for pointer.");
 
-        auto ast = std::make_unique<AST>("type");
+        auto ast = _arena.make<TypeNode>(NodeKind::Type);
         ast->setName(pointer);
-        ast->setChild("decl", std::move(decl));
+        ast->decl = decl;
+        ast->access = _arena.copy(access);
         return ast;
     }
 
@@ -1127,131 +1238,145 @@ std::unique_ptr<AST> WgslParser::_type_decl() {
     auto attrs = _attribute();
 
     // attribute* array less_than type_decl (comma element_count_expression)? greater_than
-    if (_match(Token::Keywords["array"])) {
+    if (_match(TokenKind::Array)) {
         auto array = _previous();
-        _consume(Token::Tokens["less_than"], "Expected '<' for array type.");
+        _consume(TokenKind::LessThan, "Expected '<' for array type.");
         auto format = _type_decl();
-        if (_match(Token::Tokens["comma"]))
-            _consume(Token::Tokens["element_count_expression"], "Expected element_count for array.").toString();
-        _consume(Token::Tokens["greater_than"], "Expected '>' for array.");
-
-        auto ast = std::make_unique<AST>("array");
-        ast->setName(array.toString());
-        ast->setChildVec("attributes", std::move(attrs));
-        ast->setChild("format", std::move(format));
+        uint32_t count = 0;
+        std::string_view countName;
+        if (_match(TokenKind::Comma)) {
+            auto countToken = _consume(Token::ElementCountExpression, "Expected element_count for array.");
+            if (countToken.kind() == TokenKind::Ident)
+                countName = _arena.copy(countToken.lexeme(_source));
+            else
+                count = countToken.uintValue();
+        }
+        _consume(TokenKind::GreaterThan, "Expected '>' for array.");
+
+        auto ast = _arena.make<TypeNode>(NodeKind::Array);
+        ast->setName(_symbol(array));
+        ast->attributes = _arena.copy(attrs);
+        ast->format = format;
+        ast->count = count;
+        ast->countName = countName;
         return ast;
     }
 
     return nullptr;
 }
 
-std::unique_ptr<AST> WgslParser::_texture_sampler_types() {
+TypeNode *WgslParser::_attributed_type_decl(const char *message) {
+    auto attrs = _attribute();
+    auto type = _type_decl();
+    if (!type) {
+        _error(_peek(), message);
+        return nullptr;
+    }
+    type->attributes = _arena.copy(attrs);
+    return type;
+}
+
+TypeNode *WgslParser::_texture_sampler_types() {
     // sampler_type
-    if (_match(Token::Tokens["sampler_type"])) {
-        auto ast = std::make_unique<AST>("sampler");
-        ast->setName(_previous().toString());
+    if (_match(Token::SamplerType)) {
+        auto ast = _arena.make<TypeNode>(NodeKind::Sampler);
+        ast->setName(_symbol(_previous()));
         return ast;
     }
 
     // depth_texture_type
-    if (_match(Token::Tokens["depth_texture_type"])) {
-        auto ast = std::make_unique<AST>("sampler");
-        ast->setName(_previous().toString());
+    if (_match(Token::DepthTextureType)) {
+        auto ast = _arena.make<TypeNode>(NodeKind::Sampler);
+        ast->setName(_symbol(_previous()));
         return ast;
     }
 
     // sampled_texture_type less_than type_decl greater_than
     // multisampled_texture_type less_than type_decl greater_than
-    if (_match(Token::Tokens["sampled_texture_type"]) ||
-        _match(Token::Tokens["multisampled_texture_type"])) {
+    if (_match(Token::SampledTextureType) ||
+        _match(Token::MultisampledTextureType)) {
         auto sampler = _previous();
-        _consume(Token::Tokens["less_than"], "Expected '<' for sampler type.");
+        _consume(TokenKind::LessThan, "Expected '<' for sampler type.");
         auto format = _type_decl();
-        _consume(Token::Tokens["greater_than"], "Expected '>' for sampler type.");
+        _consume(TokenKind::GreaterThan, "Expected '>' for sampler type.");
 
-        auto ast = std::make_unique<AST>("sampler");
-        ast->setName(_previous().toString());
-        ast->setChild("format", std::move(format));
+        auto ast = _arena.make<TypeNode>(NodeKind::Sampler);
+        ast->setName(_symbol(_previous()));
+        ast->format = format;
         return ast;
     }
 
     // storage_texture_type less_than texel_format comma access_mode greater_than
-    if (_match(Token::Tokens["storage_texture_type"])) {
+    if (_match(Token::StorageTextureType)) {
         auto sampler = _previous();
-        _consume(Token::Tokens["less_than"], "Expected '<' for sampler type.");
-        _consume(Token::Tokens["texel_format"], "Invalid texel format.");
-        _consume(Token::Tokens["comma"], "Expected ',' after texel format.");
-        _consume(Token::Tokens["access_mode"], "Expected access mode for storage texture type.");
-        _consume(Token::Tokens["greater_than"], "Expected '>' for sampler type.");
-
-        auto ast = std::make_unique<AST>("sampler");
-        ast->setName(_previous().toString());
+        _consume(TokenKind::LessThan, "Expected '<' for sampler type.");
+        _consume(Token::TexelFormat, "Invalid texel format.");
+        _consume(TokenKind::Comma, "Expected ',' after texel format.");
+        _consume(Token::AccessMode, "Expected access mode for storage texture type.");
+        _consume(TokenKind::GreaterThan, "Expected '>' for sampler type.");
+
+        auto ast = _arena.make<TypeNode>(NodeKind::Sampler);
+        ast->setName(_symbol(_previous()));
         return ast;
     }
 
     return nullptr;
 }
 
-std::vector<std::unique_ptr<AST>> WgslParser::_attribute() {
+std::vector<AST *> WgslParser::_attribute() {
     // attr ident paren_left (literal_or_ident comma)* literal_or_ident paren_right
     // attr ident
 
-    std::vector<std::unique_ptr<AST>> attributes{};
+    std::vector<AST *> attributes{};
 
-    while (_match(Token::Tokens["attr"])) {
-        auto name = _consume(Token::Tokens["attribute_name"],
-                             "Expected attribute name");
-        auto attr = std::make_unique<AST>("attribute");
-        attr->setName(name.toString());
-        if (_match(Token::Tokens["paren_left"])) {
-            // literal_or_ident
-            std::vector<std::string> value = {
-                    _consume(Token::Tokens["literal_or_ident"],
-                             "Expected attribute value").toString()};
-            if (_check(Token::Tokens["comma"])) {
-                _advance();
-                do {
-                    auto v = _consume(Token::Tokens["literal_or_ident"],
-                                      "Expected attribute value").toString();
-                    value.emplace_back(v);
-                } while (_match(Token::Tokens["comma"]));
-            }
-            attr->setNameVec("value", value);
-            _consume(Token::Tokens["paren_right"], "Expected ')'");
+    // The value tokens are kept next to their text, so numeric values don't need to be parsed
+    // again from the text.
+    const auto values = [&](AttributeNode *attr) {
+        // literal_or_ident
+        std::vector<Token> tokens = {_consume(Token::LiteralOrIdent, "Expected attribute value")};
+        if (_check(TokenKind::Comma)) {
+            _advance();
+            do {
+                tokens.emplace_back(_consume(Token::LiteralOrIdent, "Expected attribute value"));
+            } while (_match(TokenKind::Comma));
         }
-        attributes.emplace_back(std::move(attr));
+        std::vector<std::string_view> value;
+        value.reserve(tokens.size());
+        for (const auto &token: tokens)
+            value.emplace_back(_arena.copy(token.lexeme(_source)));
+        attr->values = _arena.copy(value);
+        auto copied = _arena.copy(tokens);
+        attr->tokens = TokenSpan(copied.data(), copied.size());
+        _consume(TokenKind::ParenRight, "Expected ')'");
+    };
+
+    while (_match(TokenKind::Attr)) {
+        auto name = _consume(Token::AttributeName,
+                             "Expected attribute name");
+        auto attr = _arena.make<AttributeNode>();
+        attr->setName(_symbol(name));
+        if (_match(TokenKind::ParenLeft))
+            values(attr);
+        attributes.emplace_back(attr);
     }
 
     // Deprecated:
     // attr_left (attribute comma)* attribute attr_right
-    while (_match(Token::Tokens["attr_left"])) {
-        if (!_check(Token::Tokens["attr_right"])) {
+    while (_match(TokenKind::AttrLeft)) {
+        if (!_check(TokenKind::AttrRight)) {
             do {
-                auto name = _consume(Token::Tokens["attribute_name"], "Expected attribute name");
-                auto attr = std::make_unique<AST>("attribute");
-                attr->setName(name.toString());
-                if (_match(Token::Tokens["paren_left"])) {
-                    // literal_or_ident
-                    std::vector<std::string> value = {_consume(Token::Tokens["literal_or_ident"],
-                                                               "Expected attribute value").toString()};
-                    if (_check(Token::Tokens["comma"])) {
-                        _advance();
-                        do {
-                            auto v = _consume(Token::Tokens["literal_or_ident"],
-                                              "Expected attribute value").toString();
-                            value.emplace_back(v);
-                        } while (_match(Token::Tokens["comma"]));
-                    }
-                    attr->setNameVec("value", value);
-                    _consume(Token::Tokens["paren_right"], "Expected ')'");
-                }
-                attributes.emplace_back(std::move(attr));
-            } while (_match(Token::Tokens["comma"]));
+                auto name = _consume(Token::AttributeName, "Expected attribute name");
+                auto attr = _arena.make<AttributeNode>();
+                attr->setName(_symbol(name));
+                if (_match(TokenKind::ParenLeft))
+                    values(attr);
+                attributes.emplace_back(attr);
+            } while (_match(TokenKind::Comma));
 
         }
         // Consume ]]
-        _consume(Token::Tokens["attr_right"], "Expected ']]' after attribute declarations");
+        _consume(TokenKind::AttrRight, "Expected ']]' after attribute declarations");
     }
 
     return attributes;
-}
\ No newline at end of file
+}
@@ -7,231 +7,222 @@
 #ifndef WGSL_INTROSPECTOR_WGSL_PARSER_H
 #define WGSL_INTROSPECTOR_WGSL_PARSER_H
 
+#include <array>
 #include <utility>
-#include "wgsl_scanner.h"
+#include "wgsl_ast.h"
+#include "wgsl_thread_pool.h"
 
-class AST {
+class WgslParser {
 public:
-    static const std::vector<std::unique_ptr<AST>> Empty;
-    static const std::vector<std::string> EmptyString;
-
-    explicit AST(const std::string &type) {
-        _type = type;
-    }
-
-    const std::string &type() {
-        return _type;
-    }
-
-    void setChild(const std::string &name, std::unique_ptr<AST> &&ast) {
-        _child[name] = std::move(ast);
-    }
-
-    [[nodiscard]] AST *child(const std::string &name) const {
-        auto iter = _child.find(name);
-        if (iter != _child.end()) {
-            return iter->second.get();
-        } else {
-            return nullptr;
-        }
+    enum class ParseMode {
+        // Parses the whole module.
+        Full,
+        // Parses the top-level declarations and function signatures, for callers like reflection
+        // that don't look into function bodies. Bodies are skipped by matching their braces, so
+        // errors in them aren't found, and their identifiers are only interned if the body is
+        // parsed later with parseBody.
+        Declarations
+    };
+
+    // Names in the ASTs are interned in symbols and the nodes are allocated in arena, which both
+    // have to outlive them.
+    WgslParser(SymbolTable &symbols, AstArena &arena, ParseMode mode = ParseMode::Full) :
+            _symbols(symbols), _arena(arena), _mode(mode) {
     }
 
-    void setChildVec(const std::string &name, std::vector<std::unique_ptr<AST>> &&ast) {
-        _childVec[name] = std::move(ast);
+    // Collects errors in diagnostics instead of throwing on the first one. A declaration or
+    // statement with an error is left out of the AST, and parsing goes on after it: past its
+    // ';' or the '}' closing its body, or at the start of the next statement or declaration,
+    // whichever comes first. The scanner of a parse from source reports into the list too. The
+    // list has to outlive the parses.
+    void setDiagnostics(std::vector<Diagnostic> *diagnostics) {
+        _diagnostics = diagnostics;
     }
 
-    [[nodiscard]] const std::vector<std::unique_ptr<AST>> &childVec(const std::string &name) const {
-        auto iter = _childVec.find(name);
-        if (iter != _childVec.end()) {
-            return iter->second;
-        } else {
-            return Empty;
-        }
-    }
-
-    void setName(const std::string &name) {
-        _name = name;
-    }
+    std::vector<AST *> parse(const std::string &code);
 
-    [[nodiscard]] const std::string &name() const {
-        return _name;
-    }
+    // Tokens are spans of source, which has to be the code they were scanned from. Their ident
+    // tokens have to be scanned without a symbol table, or with this parser's. The tokens are
+    // borrowed, not copied, so they have to outlive the parse.
+    std::vector<AST *> parse(std::string_view source, TokenSpan tokens);
 
-    void setNameVec(const std::string &name, const std::vector<std::string> &nameVec) {
-        _nameVec[name] = nameVec;
-    }
+    // Like the borrowing parse, on pool: the tokens are split between top-level declarations into
+    // runs of declarations, which are parsed concurrently into arenas of their own that this
+    // parser's arena then takes over. The ASTs and diagnostics are in source order, and the
+    // exception thrown is the one of the first error, as for a serial parse. Small modules, and
+    // any module on a pool without workers, are parsed serially.
+    std::vector<AST *> parse(std::string_view source, TokenSpan tokens, ThreadPool &pool);
 
-    [[nodiscard]] const std::vector<std::string> &nameVec(const std::string &name) const {
-        auto iter = _nameVec.find(name);
-        if (iter != _nameVec.end()) {
-            return iter->second;
-        } else {
-            return EmptyString;
-        }
-    }
+    // Like the borrowing parse, for callers that give up the tokens. The parser keeps them
+    // until the next parse.
+    std::vector<AST *> parse(std::string_view source, std::vector<Token> &&tokens);
 
-public:
-    uint32_t group() {
-        return _group;
-    }
+    // Parses tokens pulled from the scanner as the grammar needs them, so the token stream is
+    // never materialized.
+    std::vector<AST *> parse(WgslScanner &scanner);
 
-    void setGroup(uint32_t value) {
-        _group = value;
-    }
+    // Starts a streaming parse. The scanner has to outlive it.
+    void beginStream(WgslScanner &scanner);
 
-    uint32_t binding() {
-        return _binding;
-    }
+    // Parses the next top-level declaration, or returns nullptr at the end of the module.
+    AST *parseNext();
 
-    void setBinding(uint32_t value) {
-        _binding = value;
-    }
+    // Parses the body of a function whose body was skipped, pulling its tokens from scanner, a
+    // scanner of the code the function was parsed from, with the symbol table and arena of that
+    // parse. The body is kept in the function, and returned.
+    BlockNode *parseBody(FunctionNode *function, WgslScanner &scanner);
 
 private:
-    friend class WgslParser;
-
-    std::string _type;
-    std::string _name;
-    std::unordered_map<std::string, std::unique_ptr<AST>> _child{};
-    std::unordered_map<std::string, std::vector<std::unique_ptr<AST>>> _childVec{};
-    std::unordered_map<std::string, std::vector<std::string>> _nameVec;
-
-    uint32_t _group;
-    uint32_t _binding;
-};
-
-
-class WgslParser {
-public:
-    WgslParser() = default;
+    void _initialize(std::string_view source, TokenSpan tokens);
 
-    std::vector<std::unique_ptr<AST>> parse(const std::string &code);
+    std::vector<AST *> _parseAll();
 
-    std::vector<std::unique_ptr<AST>> parse(const std::vector<Token> &tokens);
+    // In a streaming parse a token stays valid until kTokenWindow more tokens are pulled, so
+    // keep a copy of any token needed for longer than a lookahead. Throws std::logic_error for
+    // a token that is already out of the window, in every build.
+    const Token &_token(size_t index);
 
-private:
-    void _initialize(const std::string &code);
+    const Symbol *_symbol(const Token &token);
 
-    void _initialize(const std::vector<Token> &tokens);
+    // Throws, or records a diagnostic and starts skipping to the next statement or declaration.
+    // While skipping, the parser acts as if it were at the end of the tokens, so the grammar
+    // functions return without consuming anything, and without reporting errors that follow
+    // from the first one.
+    void _error(const Token &token, const char *message);
 
-    void _error(const Token &token, const std::string &message);
+    // Skips the rest of a declaration, or of a statement in a statement list, with an error.
+    void _synchronize(bool inStatementList);
 
     bool _isAtEnd();
 
-    bool _match(const TokenType &types);
+    bool _match(TokenKind kind);
 
-    bool _match(const std::vector<TokenType> &types);
+    bool _match(const TokenKindSet &kinds);
 
-    bool _check(const TokenType &types);
+    bool _check(TokenKind kind);
 
-    bool _check(const std::vector<TokenType> &types);
+    bool _check(const TokenKindSet &kinds);
 
-    Token _consume(const TokenType &types, const std::string &message);
+    const Token &_consume(TokenKind kind, const char *message);
 
-    Token _consume(const std::vector<TokenType> &types, const std::string &message);
+    const Token &_consume(const TokenKindSet &kinds, const char *message);
 
-    Token _advance();
+    const Token &_advance();
 
-    Token _peek();
+    const Token &_peek();
 
-    Token _previous();
+    const Token &_previous();
 
 private:
-    std::unique_ptr<AST> _global_decl_or_directive();
-
-    std::unique_ptr<AST> _function_decl();
-
-    std::unique_ptr<AST> _compound_statement();
-
-    std::unique_ptr<AST> _statement();
-
-    std::unique_ptr<AST> _while_statement();
-
-    std::unique_ptr<AST> _for_statement();
+    AST *_global_decl_or_directive();
 
-    std::unique_ptr<AST> _for_init();
+    FunctionNode *_function_decl();
 
-    std::unique_ptr<AST> _for_increment();
+    BlockNode *_compound_statement();
 
-    std::unique_ptr<AST> _variable_statement();
+    // Matches the braces of a compound_statement without parsing it, and sets the body span of
+    // function to it.
+    void _skip_compound_statement(FunctionNode *function);
 
-    std::unique_ptr<AST> _assignment_statement();
+    std::vector<AST *> _statement_list();
 
-    std::unique_ptr<AST> _func_call_statement();
+    AST *_statement();
 
-    std::unique_ptr<AST> _loop_statement();
+    AST *_while_statement();
 
-    std::unique_ptr<AST> _switch_statement();
+    AST *_for_statement();
 
-    std::vector<std::unique_ptr<AST>> _switch_body();
+    AST *_for_init();
 
-    std::vector<std::string> _case_selectors();
+    AST *_for_increment();
 
-    std::vector<std::unique_ptr<AST>> _case_body();
+    AST *_variable_statement();
 
-    std::unique_ptr<AST> _if_statement();
+    AST *_assignment_statement();
 
-    std::vector<std::unique_ptr<AST>> _elseif_statement();
+    AST *_func_call_statement();
 
-    std::unique_ptr<AST> _return_statement();
+    AST *_loop_statement();
 
-    std::unique_ptr<AST> _short_circuit_or_expression();
+    AST *_switch_statement();
 
-    std::unique_ptr<AST> _short_circuit_and_expr();
+    std::vector<AST *> _switch_body();
 
-    std::unique_ptr<AST> _inclusive_or_expression();
+    std::vector<std::string_view> _case_selectors();
 
-    std::unique_ptr<AST> _exclusive_or_expression();
+    std::vector<AST *> _case_body();
 
-    std::unique_ptr<AST> _and_expression();
+    AST *_if_statement();
 
-    std::unique_ptr<AST> _equality_expression();
+    std::vector<AST *> _elseif_statement();
 
-    std::unique_ptr<AST> _relational_expression();
+    AST *_return_statement();
 
-    std::unique_ptr<AST> _shift_expression();
+    ExprNode *_short_circuit_or_expression();
 
-    std::unique_ptr<AST> _additive_expression();
+    ExprNode *_binary_expression(uint8_t minPrecedence, uint8_t maxPrecedence);
 
-    std::unique_ptr<AST> _multiplicative_expression();
+    ExprNode *_unary_expression();
 
-    std::unique_ptr<AST> _unary_expression();
+    ExprNode *_singular_expression();
 
-    std::unique_ptr<AST> _singular_expression();
+    ExprNode *_postfix_expression();
 
-    std::unique_ptr<AST> _postfix_expression();
+    ExprNode *_primary_expression();
 
-    std::unique_ptr<AST> _primary_expression();
+    std::vector<AST *> _argument_expression_list();
 
-    std::vector<std::unique_ptr<AST>> _argument_expression_list();
+    GroupingExprNode *_optional_paren_expression();
 
-    std::unique_ptr<AST> _optional_paren_expression();
+    GroupingExprNode *_paren_expression();
 
-    std::unique_ptr<AST> _paren_expression();
+    StructNode *_struct_decl();
 
-    std::unique_ptr<AST> _struct_decl();
+    VarNode *_global_variable_decl();
 
-    std::unique_ptr<AST> _global_variable_decl();
+    LetNode *_global_constant_decl();
 
-    std::unique_ptr<AST> _global_constant_decl();
+    CreateNode *_const_expression();
 
-    std::unique_ptr<AST> _const_expression();
+    VarNode *_variable_decl();
 
-    std::unique_ptr<AST> _variable_decl();
+    AST *_enable_directive();
 
-    std::unique_ptr<AST> _enable_directive();
+    AST *_type_alias();
 
-    std::unique_ptr<AST> _type_alias();
+    TypeNode *_type_decl();
 
-    std::unique_ptr<AST> _type_decl();
+    // attribute* type_decl, where a type is required.
+    TypeNode *_attributed_type_decl(const char *message);
 
-    std::unique_ptr<AST> _texture_sampler_types();
+    TypeNode *_texture_sampler_types();
 
-    std::vector<std::unique_ptr<AST>> _attribute();
+    std::vector<AST *> _attribute();
 
 private:
-    std::vector<Token> _tokens{};
+    // The grammar looks at most one token ahead and backtracks at most one token, so a
+    // streaming parse only keeps a small window of the most recently pulled tokens.
+    static constexpr size_t kTokenWindow = 8;
+
+    SymbolTable &_symbols;
+    AstArena &_arena;
+    ParseMode _mode;
+    std::string_view _source;
+    TokenSpan _tokens{};
+    // Stands for the tokens past the end of _tokens.
+    Token _end{};
+    // The tokens of a parse that was given ownership of them.
+    std::vector<Token> _ownedTokens{};
     size_t _current = 0;
+    std::vector<Diagnostic> *_diagnostics = nullptr;
+    // Set from an error until the parser has skipped to where it can go on.
+    bool _panic = false;
+    // False while parsers share the symbol table, which then already has every name.
+    bool _intern = true;
+
+    WgslScanner *_scanner = nullptr;
+    std::array<Token, kTokenWindow> _window{};
+    size_t _pulled = 0;
 };
 
 #endif //WGSL_INTROSPECTOR_WGSL_PARSER_H
@@ -5,8 +5,43 @@
 //  property of any third parties.
 
 #include "wgsl_reflect.h"
+#include "wgsl_mapped_file.h"
+#include "wgsl_ast_serializer.h"
 
-std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> WgslReflect::TypeInfo = {
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+uint64_t roundUp(uint64_t multiple, uint64_t value) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// The value of an attribute like @group(0) or @align(16), or fallback when there is none.
+// Throws std::runtime_error if the value isn't a non-negative integer literal.
+uint32_t attributeValue(AttributeNode *attribute, uint32_t fallback) {
+    if (!attribute)
+        return fallback;
+    const auto message = "Expected a non-negative integer literal for @" + std::string(attribute->name()) + ".";
+    if (attribute->tokens.size() != 1)
+        throw std::runtime_error(message);
+    const auto &token = attribute->tokens[0];
+    if (token.kind() != TokenKind::UintLiteral && (token.kind() != TokenKind::IntLiteral || token.intValue() < 0))
+        throw std::runtime_error(std::to_string(token.line()) + ": " + message);
+    return token.uintValue();
+}
+
+// A runtime-sized array, or a struct that ends with one, which can only be the last member of a
+// struct, or the type of a storage buffer.
+bool isRuntimeSized(const WgslReflect::TypeLayout *layout) {
+    if (layout->element)
+        return layout->count == 0;
+    return !layout->members.empty() && isRuntimeSized(layout->members.back().type);
+}
+}
+
+const std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> WgslReflect::TypeInfo = {
         {"i32",    {4,  4}},
         {"u32",    {4,  4}},
         {"f32",    {4,  4}},
@@ -26,35 +61,133 @@ std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> WgslReflect::Type
 };
 
 std::string WgslReflect::TextureTypes(const std::string &key) {
-    auto iter = Token::TextureType.find(key);
-    if (iter != Token::TextureType.end()) {
-        return iter->second.name;
+    auto type = Token::findKeyword(key);
+    if (type && Token::TextureType.contains(type->kind())) {
+        return type->name;
     } else {
         return "-1";
     }
 }
 
 std::string WgslReflect::SamplerTypes(const std::string &key) {
-    auto iter = Token::SamplerType.find(key);
-    if (iter != Token::SamplerType.end()) {
-        return iter->second.name;
+    auto type = Token::findKeyword(key);
+    if (type && Token::SamplerType.contains(type->kind())) {
+        return type->name;
     } else {
         return "-1";
     }
 }
 
-WgslReflect::WgslReflect(const std::string &code) {
-    initialize(code);
+WgslReflect::WgslReflect(const std::string &code, WgslParser::ParseMode mode) {
+    initialize(code, mode);
+}
+
+WgslReflect WgslReflect::fromFile(const std::string &path, WgslParser::ParseMode mode) {
+    auto scanner = WgslScanner::fromMapped(std::make_shared<const MappedFile>(path));
+    WgslReflect reflect;
+    reflect.initialize(scanner, mode);
+    return reflect;
+}
+
+WgslReflect WgslReflect::fromImage(std::string_view image) {
+    WgslReflect reflect;
+    reflect.initializeFromImage(image);
+    return reflect;
+}
+
+WgslReflect WgslReflect::fromImage(std::string_view image, const std::string &code) {
+    WgslReflect reflect;
+    reflect.initializeFromImage(image, code);
+    return reflect;
+}
+
+std::vector<WgslReflect::ShaderReflection> WgslReflect::reflectBatch(ArenaSpan<ShaderSource> sources,
+                                                                     const BatchOptions &options) {
+    std::vector<ShaderReflection> results(sources.size());
+    std::atomic<size_t> next{0};
+    // One task per thread, each with its own WgslReflect, taking the next shader until none are
+    // left, so no thread waits while another has a backlog.
+    const auto reflectAll = [&](size_t) {
+        WgslReflect reflect;
+        for (size_t i = next++; i < sources.size(); i = next++) {
+            // The symbols of every shader reflected so far stay interned, so a big table is
+            // dropped rather than carried along.
+            if (reflect.symbols.size() > kMaxBatchSymbols)
+                reflect = WgslReflect();
+            auto &result = results[i];
+            try {
+                // The sources outlive the batch, so they are scanned where they are, not copied.
+                auto scanner = WgslScanner::fromView(sources[i].code);
+                reflect.initialize(scanner, options.mode);
+                result.bindGroups = reflect.getBindGroups();
+                for (auto function: reflect.functions) {
+                    auto stage = getAttribute(function, "stage");
+                    if (stage && !stage->values.empty())
+                        result.entryPoints.push_back({std::string(stage->values[0]), std::string(function->name())});
+                }
+                if (options.visit)
+                    options.visit(i, reflect);
+            } catch (const std::exception &e) {
+                result = {};
+                result.error = e.what();
+            }
+        }
+    };
+
+    if (options.pool) {
+        options.pool->parallelFor(std::min(options.pool->size(), sources.size()), reflectAll);
+    } else {
+        const size_t threads = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+        if (threads < 2 || sources.size() < 2) {
+            reflectAll(0);
+        } else {
+            ThreadPool pool(std::min(threads, sources.size()) - 1);
+            pool.parallelFor(pool.size(), reflectAll);
+        }
+    }
+    return results;
+}
+
+std::vector<WgslReflect::ShaderReflection> WgslReflect::reflectBatch(const std::vector<ShaderSource> &sources,
+                                                                     const BatchOptions &options) {
+    return reflectBatch(ArenaSpan<ShaderSource>(sources.data(), sources.size()), options);
 }
 
-void WgslReflect::initialize(const std::string &code) {
-    auto parser = WgslParser();
-    ast = parser.parse(code);
+void WgslReflect::initialize(const std::string &code, WgslParser::ParseMode mode) {
+    auto scanner = WgslScanner(code);
+    initialize(scanner, mode);
+}
+
+void WgslReflect::initialize(WgslScanner &scanner, WgslParser::ParseMode mode) {
+    arena.reset();
+    auto parser = WgslParser(symbols, arena, mode);
+    ast = parser.parse(scanner);
+    if (mode == WgslParser::ParseMode::Declarations)
+        _bodyScanner = scanner;
+    else
+        _bodyScanner.reset();
+    _collect();
+}
 
+void WgslReflect::initializeFromImage(std::string_view image) {
+    arena.reset();
+    ast = AstSerializer::read(image, symbols, arena);
+    _bodyScanner.reset();
+    _collect();
+}
+
+void WgslReflect::initializeFromImage(std::string_view image, const std::string &code) {
+    initializeFromImage(image);
+    _bodyScanner = WgslScanner(code);
+}
+
+void WgslReflect::_collect() {
     // All top-level structs in the shader.
     structs = {};
     // All top-level uniform vars in the shader.
     uniforms = {};
+    // All top-level storage buffer vars in the shader.
+    storage = {};
     // All top-level texture vars in the shader;
     textures = {};
     // All top-level sampler vars in the shader.
@@ -69,144 +202,371 @@ void WgslReflect::initialize(const std::string &code) {
             {"fragment", {}},
             {"compute",  {}},
     };
-
-    for (const auto &node: ast) {
-        auto nodePtr = node.get();
-        if (nodePtr->type() == "struct")
-            structs.push_back(nodePtr);
-
-        if (nodePtr->type() == "alias")
-            aliases.push_back(nodePtr);
-
-        if (isUniformVar(nodePtr)) {
-            auto group = getAttribute(nodePtr, "group");
-            nodePtr->setGroup(group && !group->nameVec("value").empty() ?
-                              std::stoi(group->nameVec("value")[0]) : 0);
-            auto binding = getAttribute(nodePtr, "binding");
-            nodePtr->setBinding(binding && !binding->nameVec("value").empty() ?
-                                std::stoi(binding->nameVec("value")[0]) : 0);
-            uniforms.push_back(nodePtr);
-        }
-
-        if (isTextureVar(nodePtr)) {
-            auto group = getAttribute(nodePtr, "group");
-            nodePtr->setGroup(group && !group->nameVec("value").empty() ?
-                              std::stoi(group->nameVec("value")[0]) : 0);
-            auto binding = getAttribute(nodePtr, "binding");
-            nodePtr->setBinding(binding && !binding->nameVec("value").empty() ?
-                                std::stoi(binding->nameVec("value")[0]) : 0);
-            textures.push_back(nodePtr);
+    for (const auto id: _declared)
+        _declarations[id] = nullptr;
+    _declared.clear();
+    _bindings.clear();
+    _bindGroups.reset();
+    _layouts.clear();
+    _layoutStore.clear();
+
+    for (const auto node: ast) {
+        if (auto symbol = node->symbol()) {
+            if (symbol->id >= _declarations.size())
+                _declarations.resize(symbol->id + 1, nullptr);
+            if (!_declarations[symbol->id]) {
+                _declarations[symbol->id] = node;
+                _declared.push_back(symbol->id);
+            }
         }
 
-        if (isSamplerVar(nodePtr)) {
-            auto group = getAttribute(nodePtr, "group");
-            nodePtr->setGroup(group && !group->nameVec("value").empty() ?
-                              std::stoi(group->nameVec("value")[0]) : 0);
-            auto binding = getAttribute(nodePtr, "binding");
-            nodePtr->setBinding(binding && !binding->nameVec("value").empty() ?
-                                std::stoi(binding->nameVec("value")[0]) : 0);
-            samplers.push_back(nodePtr);
+        if (auto _struct = node->as<StructNode>())
+            structs.push_back(_struct);
+
+        if (auto alias = node->as<AliasNode>())
+            aliases.push_back(alias);
+
+        auto var = node->as<VarNode>();
+        if (var && (isUniformVar(var) || isStorageVar(var) || isTextureVar(var) || isSamplerVar(var))) {
+            const auto name = std::string(var->name());
+            if (!var->type)
+                throw std::runtime_error("Expected a type for the resource var " + name + ".");
+            var->setGroup(attributeValue(getAttribute(var, "group"), 0));
+            var->setBinding(attributeValue(getAttribute(var, "binding"), 0));
+            if (var->group() >= kMaxBindGroups)
+                throw std::runtime_error("The @group of " + name + " is over the limit of " +
+                                         std::to_string(kMaxBindGroups - 1) + ".");
+            if (var->binding() >= kMaxBindings)
+                throw std::runtime_error("The @binding of " + name + " is over the limit of " +
+                                         std::to_string(kMaxBindings - 1) + ".");
+            // Two vars at one binding would make getBinding and the bind group layouts disagree.
+            auto [bound, added] = _bindings.emplace(uint64_t(var->group()) << 32 | var->binding(), var);
+            if (!added)
+                throw std::runtime_error("The resource vars " + std::string(bound->second->name()) + " and " + name +
+                                         " are both at @group(" + std::to_string(var->group()) + ") @binding(" +
+                                         std::to_string(var->binding()) + ").");
+
+            if (isUniformVar(var))
+                uniforms.push_back(var);
+            if (isStorageVar(var))
+                storage.push_back(var);
+            if (isTextureVar(var))
+                textures.push_back(var);
+            if (isSamplerVar(var))
+                samplers.push_back(var);
         }
 
-        if (node->type() == "function") {
-            functions.push_back(nodePtr);
-            auto stage = getAttribute(nodePtr, "stage");
+        if (auto function = node->as<FunctionNode>()) {
+            functions.push_back(function);
+            auto stage = getAttribute(function, "stage");
             if (stage) {
                 std::vector<InputInfo> inputs{};
-                _getInputs(nodePtr, inputs);
-                node.inputs = _getInputs(nodePtr);
+                _getInputs(function, inputs);
 
                 // TODO give error about non-standard stages.
-                if (!entry[stage->nameVec("value")[0]].empty())
-                    entry[stage->nameVec("value")[0]].push_back(nodePtr);
+                auto &stageEntry = entry[std::string(stage->values[0])];
+                if (!stageEntry.empty())
+                    stageEntry.push_back(function);
                 else
-                    entry[stage->nameVec("value")[0]] = {nodePtr};
+                    stageEntry = {function};
             }
         }
     }
 }
 
+BlockNode *WgslReflect::getBody(FunctionNode *function) {
+    if (function->body || !_bodyScanner)
+        return function->body;
+    auto parser = WgslParser(symbols, arena);
+    return parser.parseBody(function, *_bodyScanner);
+}
+
 bool WgslReflect::isTextureVar(AST *node) {
-    return node->type() == "var" && WgslReflect::TextureTypes(node->child("type")->name()) != "-1";
+    auto var = node ? node->as<VarNode>() : nullptr;
+    if (!var || !var->type)
+        return false;
+    auto type = Token::findKeyword(var->type->name());
+    return type && Token::TextureType.contains(type->kind());
 }
 
 bool WgslReflect::isSamplerVar(AST *node) {
-    return node->type() == "var" && WgslReflect::SamplerTypes(node->child("type")->name()) != "-1";
+    auto var = node ? node->as<VarNode>() : nullptr;
+    if (!var || !var->type)
+        return false;
+    auto type = Token::findKeyword(var->type->name());
+    return type && Token::SamplerType.contains(type->kind());
 }
 
 bool WgslReflect::isUniformVar(AST *node) {
-    return node && node->type() == "var" && node->nameVec("storage")[0] == "uniform";
+    auto var = node ? node->as<VarNode>() : nullptr;
+    return var && var->storage == "uniform";
+}
+
+bool WgslReflect::isStorageVar(AST *node) {
+    auto var = node ? node->as<VarNode>() : nullptr;
+    return var && var->storage == "storage";
 }
 
 AST *WgslReflect::getAlias(AST *node) {
     if (!node) return nullptr;
-    if (node->type() != "type")
+    if (node->kind() != NodeKind::Type)
         return nullptr;
-    auto name = node->name();
-    for (auto u: aliases) {
-        if (u->name() == name)
-            return u->child("alias");
-    }
-    return nullptr;
+    auto alias = _getDeclaration(node->symbol());
+    return alias && alias->as<AliasNode>() ? alias->as<AliasNode>()->alias : nullptr;
 }
 
 AST *WgslReflect::getAlias(const std::string &name) {
-    if (name.empty()) return nullptr;
-    for (auto u: aliases) {
-        if (u->name() == name)
-            return u->child("alias");
-    }
-    return nullptr;
+    auto alias = _getDeclaration(symbols.find(name));
+    return alias && alias->as<AliasNode>() ? alias->as<AliasNode>()->alias : nullptr;
 }
 
-AST *WgslReflect::getStruct(AST *node) {
+StructNode *WgslReflect::getStruct(AST *node) {
     if (!node) return nullptr;
-    if (node->type() == "struct")
-        return node;
-    if (node->type() != "type")
+    if (auto _struct = node->as<StructNode>())
+        return _struct;
+    if (node->kind() != NodeKind::Type)
         return nullptr;
-    auto name = node->name();
-    for (const auto &u: structs) {
-        if (u->name() == name)
-            return u;
-    }
-    return nullptr;
+    auto _struct = _getDeclaration(node->symbol());
+    return _struct ? _struct->as<StructNode>() : nullptr;
 }
 
-AST *WgslReflect::getStruct(const std::string &name) {
-    if (name.empty()) return nullptr;
-    for (const auto u: structs) {
-        if (u->name() == name)
-            return u;
-    }
-    return nullptr;
+StructNode *WgslReflect::getStruct(const std::string &name) {
+    auto _struct = _getDeclaration(symbols.find(name));
+    return _struct ? _struct->as<StructNode>() : nullptr;
+}
+
+FunctionNode *WgslReflect::getFunction(const std::string &name) {
+    auto function = _getDeclaration(symbols.find(name));
+    return function ? function->as<FunctionNode>() : nullptr;
 }
 
-AST *WgslReflect::getAttribute(AST *node, const std::string &name) {
-    if (!node || !node->childVec("attributes").empty()) return nullptr;
-    for (const auto &a: node->childVec("attributes")) {
+VarNode *WgslReflect::getVar(const std::string &name) {
+    auto var = _getDeclaration(symbols.find(name));
+    return var ? var->as<VarNode>() : nullptr;
+}
+
+VarNode *WgslReflect::getBinding(uint32_t group, uint32_t binding) {
+    auto it = _bindings.find(uint64_t(group) << 32 | binding);
+    return it != _bindings.end() ? it->second : nullptr;
+}
+
+AttributeNode *WgslReflect::getAttribute(AST *node, const std::string &name) {
+    if (!node) return nullptr;
+    for (const auto a: node->nodeAttributes()) {
         if (a->name() == name)
-            return a.get();
+            return a->as<AttributeNode>();
     }
     return nullptr;
 }
 
-void WgslReflect::getBindGroups() {
+const WgslReflect::BindGroupTable &WgslReflect::getBindGroups() {
+    if (_bindGroups)
+        return *_bindGroups;
 
-}
+    BindGroupTable table;
+    table.bindings.reserve(_bindings.size());
+    for (const auto vars: {&uniforms, &storage, &textures, &samplers}) {
+        for (auto var: *vars)
+            table.bindings.push_back(_getBindingInfo(var));
+    }
+    std::sort(table.bindings.begin(), table.bindings.end(), [](const BindingInfo &a, const BindingInfo &b) {
+        return a.group != b.group ? a.group < b.group : a.binding < b.binding;
+    });
+
+    // Groups are checked against kMaxBindGroups as vars are collected; the checks here keep the
+    // table consistent if that ever changes.
+    const uint64_t groups = table.bindings.empty() ? 0 : uint64_t(table.bindings.back().group) + 1;
+    if (groups > kMaxBindGroups)
+        throw std::runtime_error("Bind group " + std::to_string(groups - 1) + " is over the limit.");
+    table.offsets.assign(groups + 1, 0);
+    for (const auto &binding: table.bindings) {
+        if (binding.group >= groups)
+            throw std::runtime_error("Bind group " + std::to_string(binding.group) + " is out of order.");
+        table.offsets[binding.group + 1]++;
+    }
+    for (size_t group = 0; group < groups; ++group)
+        table.offsets[group + 1] += table.offsets[group];
 
-void WgslReflect::getUniformBufferInfo(AST *node) {
+    _bindGroups = std::move(table);
+    return *_bindGroups;
+}
 
+const WgslReflect::TypeLayout *WgslReflect::getUniformBufferInfo(AST *node) {
+    auto var = node ? node->as<VarNode>() : nullptr;
+    if (!isUniformVar(var) && !isStorageVar(var))
+        return nullptr;
+    return getTypeInfo(var->type);
 }
 
-void WgslReflect::getTypeInfo(const std::string &type) {
+const WgslReflect::TypeLayout *WgslReflect::getTypeInfo(const std::string &type) {
+    auto declaration = _getDeclaration(symbols.find(type));
+    if (declaration && (declaration->as<StructNode>() || declaration->as<AliasNode>()))
+        return _getLayout(declaration);
+    return _getBuiltinLayout(type);
+}
 
+const WgslReflect::TypeLayout *WgslReflect::getTypeInfo(AST *type) {
+    if (!type)
+        return nullptr;
+    if (type->as<StructNode>() || type->kind() == NodeKind::Array)
+        return _getLayout(type);
+    if (type->kind() != NodeKind::Type)
+        return nullptr;
+    auto declaration = _getDeclaration(type->symbol());
+    if (declaration && (declaration->as<StructNode>() || declaration->as<AliasNode>()))
+        return _getLayout(declaration);
+    return _getBuiltinLayout(type->name());
 }
 
-void WgslReflect::_getInputs(const std::string &args, std::vector<InputInfo> &inputs) {
+void WgslReflect::_getInputs(AST *node, std::vector<InputInfo> &inputs) {
 
 }
 
 std::optional<WgslReflect::InputInfo> WgslReflect::_getInputInfo(AST *node) {
+    return std::nullopt;
+}
 
-}
\ No newline at end of file
+const WgslReflect::TypeLayout *WgslReflect::_getBuiltinLayout(std::string_view name) {
+    static const auto layouts = []() {
+        std::unordered_map<std::string, TypeLayout> layouts;
+        for (const auto &[type, info]: TypeInfo) {
+            auto &layout = layouts[type];
+            layout.align = info.first;
+            layout.size = info.second;
+        }
+        return layouts;
+    }();
+    auto layout = layouts.find(std::string(name));
+    return layout != layouts.end() ? &layout->second : nullptr;
+}
+
+const WgslReflect::TypeLayout *WgslReflect::_getLayout(AST *declaration) {
+    if (auto [entry, added] = _layouts.emplace(declaration, nullptr); !added)
+        return entry->second;
+    // Making the layout can add entries, so the one above is looked up again.
+    auto layout = _makeLayout(declaration);
+    _layouts[declaration] = layout;
+    return layout;
+}
+
+const WgslReflect::TypeLayout *WgslReflect::_makeLayout(AST *declaration) {
+    if (auto alias = declaration->as<AliasNode>())
+        return getTypeInfo(alias->alias);
+
+    TypeLayout layout;
+    if (auto _struct = declaration->as<StructNode>()) {
+        if (_struct->members.empty())
+            return nullptr;
+        // Every member starts at the next multiple of its alignment, and the struct is aligned
+        // to the largest of them, and padded to a multiple of it.
+        // Sizes are summed in 64 bits, so a struct over 4 GB is caught instead of wrapping around.
+        uint64_t end = 0;
+        for (const auto node: _struct->members) {
+            auto member = node->as<MemberNode>();
+            auto type = getTypeInfo(member->type);
+            if (!type)
+                return nullptr;
+            // Only the last member can be runtime-sized, and only as an array.
+            if (isRuntimeSized(type) && (node != _struct->members[_struct->members.size() - 1] || !type->element))
+                return nullptr;
+            const uint32_t align = attributeValue(getAttribute(member, "align"), type->align);
+            auto sizeAttribute = getAttribute(member, "size");
+            const uint32_t size = attributeValue(sizeAttribute, type->size);
+            // @align has to be a power of two, and @size at least 1 and the size of the type.
+            if (align == 0 || (align & (align - 1)) != 0 || size < type->size || (sizeAttribute && size == 0))
+                return nullptr;
+            const uint64_t offset = roundUp(align, end);
+            end = offset + size;
+            if (end > UINT32_MAX)
+                return nullptr;
+            layout.members.push_back({member->name(), static_cast<uint32_t>(offset), align, size, type});
+            layout.align = std::max(layout.align, align);
+        }
+        const uint64_t size = roundUp(layout.align, end);
+        if (size > UINT32_MAX)
+            return nullptr;
+        layout.size = static_cast<uint32_t>(size);
+    } else {
+        auto array = declaration->as<TypeNode>();
+        // The count of an array sized by a constant isn't known without evaluating the constant,
+        // and laying it out as runtime-sized would misplace whatever follows it.
+        if (!array->countName.empty())
+            return nullptr;
+        auto element = getTypeInfo(array->format);
+        if (!element || isRuntimeSized(element))
+            return nullptr;
+        const uint64_t stride = roundUp(element->align, element->size);
+        if (stride > UINT32_MAX)
+            return nullptr;
+        layout.align = element->align;
+        layout.element = element;
+        layout.stride = attributeValue(getAttribute(array, "stride"), static_cast<uint32_t>(stride));
+        // @stride has to be a multiple of the alignment of the elements, and leave room for them.
+        if (layout.stride == 0 || layout.stride % element->align != 0 || layout.stride < element->size)
+            return nullptr;
+        layout.count = array->count;
+        const uint64_t size = uint64_t(layout.stride) * layout.count;
+        if (size > UINT32_MAX)
+            return nullptr;
+        layout.size = static_cast<uint32_t>(size);
+    }
+    return &_layoutStore.emplace_back(std::move(layout));
+}
+
+WgslReflect::BindingInfo WgslReflect::_getBindingInfo(VarNode *var) {
+    BindingInfo info{};
+    info.group = var->group();
+    info.binding = var->binding();
+    info.format = TokenKind::Eof;
+
+    auto type = var->type;
+    auto keyword = Token::findKeyword(type->name());
+    info.type = keyword ? keyword->kind() : TokenKind::Ident;
+    if (type->format) {
+        auto format = Token::findKeyword(type->format->name());
+        info.format = format ? format->kind() : TokenKind::Ident;
+    }
+
+    const auto access = [](std::string_view access) {
+        if (access == "read_write")
+            return AccessMode::ReadWrite;
+        return access == "write" ? AccessMode::Write : AccessMode::Read;
+    };
+    if (isUniformVar(var) || isStorageVar(var)) {
+        info.resourceType = isUniformVar(var) ? ResourceType::Uniform : ResourceType::Storage;
+        info.access = access(var->access);
+        auto layout = getTypeInfo(type);
+        info.size = layout ? layout->size : 0;
+        // Formats are only kept for textures.
+        info.format = TokenKind::Eof;
+    } else if (isSamplerVar(var)) {
+        info.resourceType = ResourceType::Sampler;
+    } else if (Token::StorageTextureType.contains(info.type)) {
+        info.resourceType = ResourceType::StorageTexture;
+        info.access = access(type->access);
+    } else {
+        info.resourceType = ResourceType::Texture;
+    }
+    return info;
+}
+
+AST *WgslReflect::_getDeclaration(const Symbol *symbol) const {
+    if (!symbol || symbol->id >= _declarations.size())
+        return nullptr;
+    return _declarations[symbol->id];
+}
+
+size_t WgslReflect::BindGroupTable::hash() const {
+    static_assert(std::has_unique_object_representations_v<BindingInfo>, "BindingInfo is hashed bytewise");
+    // FNV-1a, over the bindings only, since the offsets follow from them.
+    uint64_t hash = 14695981039346656037ull;
+    const auto bytes = reinterpret_cast<const uint8_t *>(bindings.data());
+    for (size_t i = 0; i < bindings.size() * sizeof(BindingInfo); ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return static_cast<size_t>(hash);
+}
+
+bool WgslReflect::BindGroupTable::operator==(const BindGroupTable &other) const {
+    return bindings.size() == other.bindings.size() &&
+           std::memcmp(bindings.data(), other.bindings.data(), bindings.size() * sizeof(BindingInfo)) == 0;
+}
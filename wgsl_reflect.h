@@ -7,6 +7,7 @@
 #ifndef WGSL_INTROSPECTOR_WGSL_REFLECT_H
 #define WGSL_INTROSPECTOR_WGSL_REFLECT_H
 
+#include <deque>
 #include "wgsl_parser.h"
 
 class WgslReflect {
@@ -19,16 +20,177 @@ public:
         uint32_t location;
     };
 
+    enum class ResourceType : uint8_t {
+        Uniform,
+        Storage,
+        Texture,
+        StorageTexture,
+        Sampler
+    };
+
+    enum class AccessMode : uint8_t {
+        None,
+        Read,
+        Write,
+        ReadWrite
+    };
+
+    // A binding of a bind group layout. It only holds plain values, without padding, so tables
+    // of them compare and hash bytewise.
+    struct BindingInfo {
+        uint32_t group;
+        uint32_t binding;
+        // The size of a buffer in bytes; for a runtime-sized array, of what comes before it. 0
+        // for textures and samplers.
+        uint32_t size;
+        // The keyword of the type of the var, or TokenKind::Ident for a struct or an alias.
+        TokenKind type;
+        // The sampled type or texel format of a texture, TokenKind::Eof for any other var.
+        TokenKind format;
+        ResourceType resourceType;
+        AccessMode access;
+        uint16_t unused;
+    };
+
+    // The @group and @binding numbers resource vars can have, plus one; a var over them is an
+    // error. They are well above the WebGPU limits, 4 groups and 1000 bindings by default, and
+    // keep a BindGroupTable, which has an entry per group up to the last one used, small.
+    static constexpr uint32_t kMaxBindGroups = 32;
+    static constexpr uint32_t kMaxBindings = 65536;
+
+    // The bind group layouts of a shader, as one array of all the bindings, sorted by group and
+    // then by binding, and the start of every group in it. Groups no var uses are empty.
+    struct BindGroupTable {
+        std::vector<BindingInfo> bindings;
+        // The bindings of group g are from offsets[g] to offsets[g + 1].
+        std::vector<uint32_t> offsets;
+
+        [[nodiscard]] size_t groupCount() const {
+            return offsets.empty() ? 0 : offsets.size() - 1;
+        }
+
+        // The bindings of group, sorted by binding.
+        [[nodiscard]] ArenaSpan<BindingInfo> group(size_t group) const {
+            if (group >= groupCount())
+                return {};
+            return {bindings.data() + offsets[group], offsets[group + 1] - offsets[group]};
+        }
+
+        [[nodiscard]] size_t hash() const;
+
+        bool operator==(const BindGroupTable &other) const;
+
+        bool operator!=(const BindGroupTable &other) const {
+            return !(*this == other);
+        }
+    };
+
+    struct TypeLayout;
+
+    // A member of a struct, with the alignment and size of its @align and @size when it has them.
+    struct MemberLayout {
+        std::string_view name;
+        // From the start of the struct.
+        uint32_t offset;
+        uint32_t align;
+        uint32_t size;
+        const TypeLayout *type;
+    };
+
+    // The memory layout of a host-shareable type, following the WGSL rules. The size of a
+    // runtime-sized array is 0, so a struct that ends with one is sized up to the array.
+    struct TypeLayout {
+        uint32_t align = 0;
+        uint32_t size = 0;
+        // For an array: the layout of its elements, the bytes from one to the next, and their
+        // count, 0 when the array is runtime-sized.
+        const TypeLayout *element = nullptr;
+        uint32_t stride = 0;
+        uint32_t count = 0;
+        // For a struct: its members in order.
+        std::vector<MemberLayout> members;
+    };
+
+    // A shader of a batch. Its code is scanned in place, without a copy, so it has to stay valid
+    // until the batch returns.
+    struct ShaderSource {
+        std::string_view code;
+    };
+
+    // An entry point: its stage, vertex, fragment or compute, and the name of its function.
+    struct EntryPoint {
+        std::string stage;
+        std::string name;
+    };
+
+    // What reflectBatch keeps of the reflection of a shader. It doesn't refer to the ASTs, which
+    // are gone once the batch returns.
+    struct ShaderReflection {
+        // What the reflection threw, empty if it didn't.
+        std::string error;
+        BindGroupTable bindGroups;
+        std::vector<EntryPoint> entryPoints;
+
+        [[nodiscard]] bool ok() const {
+            return error.empty();
+        }
+    };
+
+    struct BatchOptions {
+        // The pool to reflect on. Without one, the batch makes a pool of threads threads, counting
+        // the calling thread, or of all the hardware threads for 0.
+        ThreadPool *pool = nullptr;
+        size_t threads = 0;
+        WgslParser::ParseMode mode = WgslParser::ParseMode::Full;
+        // Called with the index of every shader that reflects, and its reflection, on the thread
+        // that reflected it, for what ShaderReflection doesn't keep. The reflection is only valid
+        // during the call. What it throws is the error of the shader.
+        std::function<void(size_t, WgslReflect &)> visit;
+    };
+
     // type: align, size
-    static std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> TypeInfo;
+    static const std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> TypeInfo;
 
     static std::string TextureTypes(const std::string &key);
 
     static std::string SamplerTypes(const std::string &key);
 
-    WgslReflect(const std::string &code);
+    // With ParseMode::Declarations, function bodies are skipped, and parsed by getBody on
+    // request.
+    WgslReflect(const std::string &code, WgslParser::ParseMode mode = WgslParser::ParseMode::Full);
+
+    // Reflects a shader file. The file is mapped read-only and scanned in place, instead of
+    // being read into a string first.
+    static WgslReflect fromFile(const std::string &path, WgslParser::ParseMode mode = WgslParser::ParseMode::Full);
+
+    // Reflects the ASTs of an AstSerializer image, without scanning or parsing. The image isn't
+    // needed after. Throws std::runtime_error if it isn't a usable image.
+    static WgslReflect fromImage(std::string_view image);
+
+    // Like fromImage, for an image of code. The bodies an image of a declarations parse doesn't
+    // have are parsed from code by getBody, as for a WgslReflect of code in that mode.
+    static WgslReflect fromImage(std::string_view image, const std::string &code);
+
+    // Reflects many shaders concurrently, and returns their reflections in the order of sources.
+    // A shader that fails to reflect gets its error, without stopping the others. Every thread
+    // reflects its shaders in a WgslReflect of its own, so the arena and tables of one shader are
+    // reused for the next.
+    static std::vector<ShaderReflection> reflectBatch(ArenaSpan<ShaderSource> sources,
+                                                      const BatchOptions &options);
+
+    static std::vector<ShaderReflection> reflectBatch(const std::vector<ShaderSource> &sources,
+                                                      const BatchOptions &options);
+
+    void initialize(const std::string &code, WgslParser::ParseMode mode = WgslParser::ParseMode::Full);
 
-    void initialize(const std::string &code);
+    void initialize(WgslScanner &scanner, WgslParser::ParseMode mode = WgslParser::ParseMode::Full);
+
+    void initializeFromImage(std::string_view image);
+
+    void initializeFromImage(std::string_view image, const std::string &code);
+
+    // The body of a function of the shader, parsed on the first request if it was skipped.
+    BlockNode *getBody(FunctionNode *function);
 
     bool isTextureVar(AST *node);
 
@@ -36,44 +198,114 @@ public:
 
     bool isUniformVar(AST *node);
 
+    bool isStorageVar(AST *node);
+
     AST* getAlias(AST* node);
 
     AST* getAlias(const std::string &name);
 
-    AST* getStruct(AST* node);
+    StructNode *getStruct(AST *node);
+
+    StructNode *getStruct(const std::string &name);
+
+    FunctionNode *getFunction(const std::string &name);
+
+    // A top-level var, of any storage class.
+    VarNode *getVar(const std::string &name);
 
-    AST* getStruct(const std::string &name);
+    // The uniform, storage, texture or sampler var bound at group and binding. Reflecting a shader
+    // with two of them at the same binding throws.
+    VarNode *getBinding(uint32_t group, uint32_t binding);
 
-    static AST *getAttribute(AST *node, const std::string &name);
+    static AttributeNode *getAttribute(AST *node, const std::string &name);
 
-    void getBindGroups();
+    // The bind group layouts of the resource vars, built on the first call.
+    const BindGroupTable &getBindGroups();
 
-    void getUniformBufferInfo(AST *node);
+    // The layout of the type of a uniform or storage buffer var, nullptr for any other node.
+    const TypeLayout *getUniformBufferInfo(AST *node);
 
-    void getTypeInfo(const std::string &type);
+    // The layout of a type, by its name, or of a type or struct node. nullptr for a type that
+    // isn't host-shareable, isn't declared, or can't be laid out: one with an array sized by a
+    // named constant, an invalid @align, @size or @stride, a runtime-sized array anywhere but at
+    // the end of a struct, or a size over 4 GB. Layouts are computed once per type, and stay
+    // valid until the next initialize.
+    const TypeLayout *getTypeInfo(const std::string &type);
+
+    const TypeLayout *getTypeInfo(AST *type);
 
 private:
-    void _getInputs(const std::string &args, std::vector<InputInfo> &inputs);
+    // The symbols a WgslReflect of reflectBatch keeps interned before it is replaced.
+    static constexpr size_t kMaxBatchSymbols = 64 * 1024;
+
+    WgslReflect() = default;
+
+    // Collects the declarations, resources and entry points of ast.
+    void _collect();
+
+    void _getInputs(AST *node, std::vector<InputInfo> &inputs);
 
     std::optional<InputInfo> _getInputInfo(AST *node);
 
+    // The layouts of the scalar, vector and matrix types, from TypeInfo.
+    static const TypeLayout *_getBuiltinLayout(std::string_view name);
+
+    // The layout of declaration, a struct, or the type of an alias or an array, which keys its
+    // entry in _layouts.
+    const TypeLayout *_getLayout(AST *declaration);
+
+    const TypeLayout *_makeLayout(AST *declaration);
+
+    BindingInfo _getBindingInfo(VarNode *var);
+
+    // The top-level declaration named symbol, or nullptr.
+    AST *_getDeclaration(const Symbol *symbol) const;
+
+    // The top-level declarations by the id of their name's symbol, so looking a name up is an
+    // index instead of a scan of the declarations. Null for the other symbols. Where a name is
+    // declared twice, the first declaration is kept. It only grows as far as the highest id
+    // declared, which can be less than the size of the symbol table.
+    std::vector<AST *> _declarations;
+    // The ids set in _declarations, so a reflection only clears the entries of the one before,
+    // instead of an entry for every symbol the table has interned.
+    std::vector<uint32_t> _declared;
+    // The resource vars by group << 32 | binding.
+    std::unordered_map<uint64_t, VarNode *> _bindings;
+    std::optional<BindGroupTable> _bindGroups;
+    // The layouts computed so far, by the node they are for; nullptr for a type that isn't
+    // host-shareable, and while the layout is being made, which stops a struct or an alias that
+    // refers to itself. _layoutStore owns them, and keeps them in place as it grows.
+    std::unordered_map<const AST *, const TypeLayout *> _layouts;
+    std::deque<TypeLayout> _layoutStore;
+
+    // A copy of the scanner of a declarations parse, which shares its source, for getBody.
+    std::optional<WgslScanner> _bodyScanner;
+
 public:
-    std::vector<std::unique_ptr<AST>> ast;
+    // The names in ast are symbols of this table.
+    SymbolTable symbols;
+
+    // Owns the nodes of ast, and everything they point to.
+    AstArena arena;
+
+    std::vector<AST *> ast;
 
     // All top-level structs in the shader.
-    std::vector<AST *> structs{};
+    std::vector<StructNode *> structs{};
     // All top-level uniform vars in the shader.
-    std::vector<AST *> uniforms{};
+    std::vector<VarNode *> uniforms{};
+    // All top-level storage buffer vars in the shader.
+    std::vector<VarNode *> storage{};
     // All top-level texture vars in the shader;
-    std::vector<AST *> textures{};
+    std::vector<VarNode *> textures{};
     // All top-level sampler vars in the shader.
-    std::vector<AST *> samplers{};
+    std::vector<VarNode *> samplers{};
     // All top-level functions in the shader.
-    std::vector<AST *> functions{};
+    std::vector<FunctionNode *> functions{};
     // All top-level type aliases in the shader.
-    std::vector<AST *> aliases{};
+    std::vector<AliasNode *> aliases{};
     // All entry functions in the shader: vertex, fragment, and/or compute.
-    std::unordered_map<std::string, std::vector<AST *>> entry;
+    std::unordered_map<std::string, std::vector<FunctionNode *>> entry;
 };
 
 #endif //WGSL_INTROSPECTOR_WGSL_REFLECT_H
@@ -0,0 +1,83 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_reflection_cache.h"
+#include "wgsl_ast_serializer.h"
+#include "wgsl_mapped_file.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+// The suffix of a temporary file, unique to this process and write, so that writers of the same
+// entry never share one.
+std::string temporarySuffix() {
+    static const uint64_t process = (uint64_t(std::random_device()()) << 32) | std::random_device()();
+    static std::atomic<uint64_t> writes{0};
+    char suffix[48];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx.%llu.tmp", static_cast<unsigned long long>(process),
+                  static_cast<unsigned long long>(writes++));
+    return suffix;
+}
+}
+
+ReflectionCache::ReflectionCache(std::string directory) : _directory(std::move(directory)) {
+    std::filesystem::create_directories(_directory);
+}
+
+WgslReflect ReflectionCache::reflect(const std::string &code) {
+    const auto hash = AstSerializer::hash(code);
+    const auto file = _path(hash);
+    try {
+        const MappedFile image(file);
+        // The name only has the hash of the source; the size guards against a collision, or a
+        // file that isn't what its name says.
+        if (AstSerializer::sourceHash(image.view()) == hash && AstSerializer::sourceSize(image.view()) == code.size()) {
+            auto reflect = WgslReflect::fromImage(image.view(), code);
+            _hits++;
+            return reflect;
+        }
+    } catch (const std::runtime_error &) {
+        // Not cached yet, or not readable; either way it is reflected again below.
+    }
+
+    _misses++;
+    WgslReflect reflect(code, WgslParser::ParseMode::Declarations);
+    _store(file, AstSerializer::write(code, reflect.ast));
+    return reflect;
+}
+
+std::string ReflectionCache::path(std::string_view code) const {
+    return _path(AstSerializer::hash(code));
+}
+
+std::string ReflectionCache::_path(uint64_t hash) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%016llx-%u.%u.ast", static_cast<unsigned long long>(hash),
+                  AstSerializer::kVersion, kVersion);
+    return (std::filesystem::path(_directory) / name).string();
+}
+
+void ReflectionCache::_store(const std::string &path, const std::string &image) {
+    const auto temporary = path + temporarySuffix();
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(image.data(), static_cast<std::streamsize>(image.size()));
+        if (!out.flush()) {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    // Replaces the entry in one step; if another writer got there first, it wrote the same image.
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+}
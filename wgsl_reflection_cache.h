@@ -0,0 +1,62 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_REFLECTION_CACHE_H
+#define WGSL_INTROSPECTOR_WGSL_REFLECTION_CACHE_H
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include "wgsl_reflect.h"
+
+//MARK: - ReflectionCache
+// A cache of reflections in a directory, for shaders that are reflected again and again without
+// changing, like on every incremental build. Each source is cached as the AstSerializer image of
+// a ParseMode::Declarations parse of it, which leaves the function bodies out, in a file named
+// after the hash of the source and the version of the image layout, so a hit loads the image
+// instead of scanning and parsing, and images of another version are never read. Bodies are
+// parsed from the source by getBody when asked for, on a hit as on a miss. A file is only used
+// when the hash and the size of the source its image was written from match too.
+//
+// Files are written to a temporary name and renamed into place, so readers only ever see whole
+// files, and several processes or threads can share a directory. A cache is safe to use from
+// several threads.
+class ReflectionCache {
+public:
+    // Bumped, along with AstSerializer::kVersion, whenever what is cached changes.
+    static constexpr uint32_t kVersion = 2;
+
+    // Caches in directory, creating it if it doesn't exist. Throws std::filesystem::filesystem_error
+    // if it can't be created.
+    explicit ReflectionCache(std::string directory);
+
+    // Reflects code like WgslReflect(code, WgslParser::ParseMode::Declarations), from the cache
+    // when it is there. On a miss code is reflected and stored; failing to store it only loses
+    // the entry. A cached image that can't be read is a miss.
+    WgslReflect reflect(const std::string &code);
+
+    // The file the reflection of code is cached in.
+    [[nodiscard]] std::string path(std::string_view code) const;
+
+    [[nodiscard]] size_t hits() const {
+        return _hits;
+    }
+
+    [[nodiscard]] size_t misses() const {
+        return _misses;
+    }
+
+private:
+    [[nodiscard]] std::string _path(uint64_t hash) const;
+
+    void _store(const std::string &path, const std::string &image);
+
+    std::string _directory;
+    std::atomic<size_t> _hits{0};
+    std::atomic<size_t> _misses{0};
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_REFLECTION_CACHE_H
@@ -5,408 +5,1036 @@
 //  property of any third parties.
 
 #include "wgsl_scanner.h"
+#include "wgsl_mapped_file.h"
+#include "wgsl_symbol_table.h"
 
-const TokenType Token::TokenEOF = {
-        "EOF",
-        "token",
-        "-1",
-        false
-};
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WGSL_SCANNER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WGSL_SCANNER_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+const TokenType &Token::TokenEOF() {
+    static const TokenType eof = {
+            "EOF",
+            "token",
+            "-1",
+            false
+    };
+    return eof;
+}
+
+const std::unordered_map<std::string, std::string> &Token::WgslTokens() {
+    static const std::unordered_map<std::string, std::string> tokens = {
+            {"decimal_float_literal", R"(((-?[0-9]*\.[0-9]+|-?[0-9]+\.[0-9]*)((e|E)(\+|-)?[0-9]+)?f?)|(-?[0-9]+(e|E)(\+|-)?[0-9]+f?))"},
+            {"hex_float_literal",     R"(-?0x((([0-9a-fA-F]*\.[0-9a-fA-F]+|[0-9a-fA-F]+\.[0-9a-fA-F]*)((p|P)(\+|-)?[0-9]+f?)?)|([0-9a-fA-F]+(p|P)(\+|-)?[0-9]+f?)))"},
+            {"int_literal",           "-?0x[0-9a-fA-F]+|0|-?[1-9][0-9]*"},
+            {"uint_literal",          "0x[0-9a-fA-F]+u|0u|[1-9][0-9]*u"},
+            {"ident",                 "[a-zA-Z][0-9a-zA-Z_]*"},
+            {"and",                   "&"},
+            {"and_and",               "&&"},
+            {"arrow",                 "->"},
+            {"attr",                  "@"},
+            {"attr_left",             "[["},
+            {"attr_right",            "]]"},
+            {"forward_slash",         "/"},
+            {"bang",                  "!"},
+            {"bracket_left",          "["},
+            {"bracket_right",         "]"},
+            {"brace_left",            "{"},
+            {"brace_right",           "}"},
+            {"colon",                 ":"},
+            {"comma",                 ","},
+            {"equal",                 "="},
+            {"equal_equal",           "=="},
+            {"not_equal",             "!="},
+            {"greater_than",          ">"},
+            {"greater_than_equal",    ">="},
+            {"shift_right",           ">>"},
+            {"less_than",             "<"},
+            {"less_than_equal",       "<="},
+            {"shift_left",            "<<"},
+            {"modulo",                "%"},
+            {"minus",                 "-"},
+            {"minus_minus",           "--"},
+            {"period",                "."},
+            {"plus",                  "+"},
+            {"plus_plus",             "++"},
+            {"or",                    "|"},
+            {"or_or",                 "||"},
+            {"paren_left",            "("},
+            {"paren_right",           ")"},
+            {"semicolon",             ";"},
+            {"star",                  "*"},
+            {"tilde",                 "~"},
+            {"underscore",            "_"},
+            {"xor",                   "^"},
+    };
+    return tokens;
+}
+
+namespace {
+#define WGSL_SPELLING(kind, name) name,
+constexpr std::string_view kWgslTokenNames[] = {WGSL_TOKENS(WGSL_SPELLING)};
 
-const std::unordered_map<std::string, std::string> Token::WgslTokens = {
-        {"decimal_float_literal", R"((/((-?[0-9]*\.[0-9]+|-?[0-9]+\.[0-9]*)((e|E)(\+|-)?[0-9]+)?f?)|(-?[0-9]+(e|E)(\+|-)?[0-9]+f?)/))"},
-        {"hex_float_literal",     R"(/-?0x((([0-9a-fA-F]*\.[0-9a-fA-F]+|[0-9a-fA-F]+\.[0-9a-fA-F]*)((p|P)(\+|-)?[0-9]+f?)?)|([0-9a-fA-F]+(p|P)(\+|-)?[0-9]+f?))/)"},
-        {"int_literal",           "/-?0x[0-9a-fA-F]+|0|-?[1-9][0-9]*/"},
-        {"uint_literal",          "/0x[0-9a-fA-F]+u|0u|[1-9][0-9]*u/"},
-        {"ident",                 "/[a-zA-Z][0-9a-zA-Z_]*/"},
-        {"and",                   "&"},
-        {"and_and",               "&&"},
-        {"arrow",                 "->"},
-        {"attr",                  "@"},
-        {"attr_left",             "[["},
-        {"attr_right",            "]]"},
-        {"forward_slash",         "/"},
-        {"bang",                  "!"},
-        {"bracket_left",          "["},
-        {"bracket_right",         "]"},
-        {"brace_left",            "{"},
-        {"brace_right",           "}"},
-        {"colon",                 ":"},
-        {"comma",                 ","},
-        {"equal",                 "="},
-        {"equal_equal",           "=="},
-        {"not_equal",             "!="},
-        {"greater_than",          ">"},
-        {"greater_than_equal",    ">="},
-        {"shift_right",           ">>"},
-        {"less_than",             "<"},
-        {"less_than_equal",       "<="},
-        {"shift_left",            "<<"},
-        {"modulo",                "%"},
-        {"minus",                 "-"},
-        {"minus_minus",           "--"},
-        {"period",                "."},
-        {"plus",                  "+"},
-        {"plus_plus",             "++"},
-        {"or",                    "|"},
-        {"or_or",                 "||"},
-        {"paren_left",            "("},
-        {"paren_right",           ")"},
-        {"semicolon",             ";"},
-        {"star",                  "*"},
-        {"tilde",                 "~"},
-        {"underscore",            "_"},
-        {"xor",                   "^"},
+constexpr std::string_view kWgslKeywords[] = {WGSL_KEYWORDS(WGSL_SPELLING)};
+
+constexpr std::string_view kWgslReserved[] = {WGSL_RESERVED(WGSL_SPELLING)};
+#undef WGSL_SPELLING
+
+// Keywords follow EOF and the tokens in TokenKind.
+constexpr size_t kFirstKeyword = 1 + std::size(kWgslTokenNames);
+static_assert(static_cast<TokenKind>(kFirstKeyword) == TokenKind::Array, "TokenKind and the keyword tables disagree");
+
+// WGSL grammar has a few keywords that have different token names than the strings they
+// represent: {alias, keyword}.
+constexpr std::string_view kKeywordAliases[][2] = {
+        {"int32",   "i32"},
+        {"uint32",  "u32"},
+        {"float32", "f32"},
+        {"pointer", "ptr"},
 };
 
-const std::vector<std::string> Token::WgslKeywords = {
-        "array",
-        "atomic",
-        "bool",
-        "f32",
-        "i32",
-        "mat2x2",
-        "mat2x3",
-        "mat2x4",
-        "mat3x2",
-        "mat3x3",
-        "mat3x4",
-        "mat4x2",
-        "mat4x3",
-        "mat4x4",
-        "ptr",
-        "sampler",
-        "sampler_comparison",
-        "struct",
-        "texture_1d",
-        "texture_2d",
-        "texture_2d_array",
-        "texture_3d",
-        "texture_cube",
-        "texture_cube_array",
-        "texture_multisampled_2d",
-        "texture_storage_1d",
-        "texture_storage_2d",
-        "texture_storage_2d_array",
-        "texture_storage_3d",
-        "texture_depth_2d",
-        "texture_depth_2d_array",
-        "texture_depth_cube",
-        "texture_depth_cube_array",
-        "texture_depth_multisampled_2d",
-        "u32",
-        "vec2",
-        "vec3",
-        "vec4",
-        "bitcast",
-        "block",
-        "break",
-        "case",
-        "continue",
-        "continuing",
-        "default",
-        "discard",
-        "else",
-        "elseif",
-        "enable",
-        "fallthrough",
-        "false",
-        "fn",
-        "for",
-        "function",
-        "if",
-        "let",
-        "loop",
-        "while",
-        "private",
-        "read",
-        "read_write",
-        "return",
-        "storage",
-        "switch",
-        "true",
-        "type",
-        "uniform",
-        "var",
-        "workgroup",
-        "write",
-        "r8unorm",
-        "r8snorm",
-        "r8uint",
-        "r8sint",
-        "r16uint",
-        "r16sint",
-        "r16float",
-        "rg8unorm",
-        "rg8snorm",
-        "rg8uint",
-        "rg8sint",
-        "r32uint",
-        "r32sint",
-        "r32float",
-        "rg16uint",
-        "rg16sint",
-        "rg16float",
-        "rgba8unorm",
-        "rgba8unorm_srgb",
-        "rgba8snorm",
-        "rgba8uint",
-        "rgba8sint",
-        "bgra8unorm",
-        "bgra8unorm_srgb",
-        "rgb10a2unorm",
-        "rg11b10float",
-        "rg32uint",
-        "rg32sint",
-        "rg32float",
-        "rgba16uint",
-        "rgba16sint",
-        "rgba16float",
-        "rgba32uint",
-        "rgba32sint",
-        "rgba32float"
+constexpr size_t kKeywordCount = std::size(kWgslKeywords) + std::size(kWgslReserved);
+constexpr size_t kSpellingCount = kKeywordCount + std::size(kKeywordAliases);
+
+// Perfect hash over every keyword, reserved word and alias spelling, searched for at compile
+// time. Identifiers are scanned first and then classified with a single probe.
+class KeywordHash {
+public:
+    static constexpr size_t kSlots = 2048;
+
+    constexpr KeywordHash() {
+        size_t n = 0;
+        for (auto keyword: kWgslKeywords) {
+            _spelling[n] = keyword;
+            _keyword[n] = static_cast<uint8_t>(n);
+            n++;
+        }
+        for (auto keyword: kWgslReserved) {
+            _spelling[n] = keyword;
+            _keyword[n] = static_cast<uint8_t>(n);
+            n++;
+        }
+        for (const auto &alias: kKeywordAliases) {
+            _spelling[n] = alias[0];
+            for (size_t i = 0; i < kKeywordCount; ++i) {
+                if (_spelling[i] == alias[1])
+                    _keyword[n] = static_cast<uint8_t>(i);
+            }
+            n++;
+        }
+
+        // Try seeds until every spelling lands in its own slot.
+        for (;; ++_seed) {
+            for (auto &slot: _slots)
+                slot = 0;
+            bool collision = false;
+            for (size_t i = 0; i < kSpellingCount && !collision; ++i) {
+                auto &slot = _slots[hash(_spelling[i], _seed)];
+                collision = slot != 0;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if (!collision)
+                break;
+        }
+    }
+
+    // Returns the index of the keyword in kWgslKeywords + kWgslReserved, resolving aliases,
+    // or -1 if the lexeme is not a keyword.
+    [[nodiscard]] constexpr int find(std::string_view lexeme) const {
+        const auto slot = _slots[hash(lexeme, _seed)];
+        if (slot == 0 || _spelling[slot - 1] != lexeme)
+            return -1;
+        return _keyword[slot - 1];
+    }
+
+    [[nodiscard]] constexpr uint32_t seed() const {
+        return _seed;
+    }
+
+private:
+    static constexpr uint32_t hash(std::string_view lexeme, uint32_t seed) {
+        uint32_t h = seed;
+        for (char c: lexeme)
+            h = (h ^ uint8_t(c)) * 16777619u;
+        return (h ^ (h >> 15)) & (kSlots - 1);
+    }
+
+    std::string_view _spelling[kSpellingCount]{};
+    uint8_t _keyword[kSpellingCount]{};
+    // Spelling index + 1, 0 for an empty slot.
+    uint8_t _slots[kSlots]{};
+    uint32_t _seed = 2166136261u;
 };
 
-const std::vector<std::string> Token::WgslReserved = {
-        "asm",
-        "bf16",
-        "const",
-        "do",
-        "enum",
-        "f16",
-        "f64",
-        "handle",
-        "i8",
-        "i16",
-        "i64",
-        "mat",
-        "premerge",
-        "regardless",
-        "typedef",
-        "u8",
-        "u16",
-        "u64",
-        "unless",
-        "using",
-        "vec",
-        "void"
+static_assert(kSpellingCount < 255, "KeywordHash stores spelling indices in a byte");
+
+constexpr KeywordHash kKeywordHash{};
+
+static_assert(kKeywordHash.find("texture_storage_2d_array") >= 0 && kKeywordHash.find("float32") >= 0 &&
+              kKeywordHash.find("vec5") < 0, "KeywordHash lost a keyword");
+}
+
+const std::vector<std::string> &Token::WgslKeywords() {
+    static const std::vector<std::string> keywords(std::begin(kWgslKeywords), std::end(kWgslKeywords));
+    return keywords;
+}
+
+const std::vector<std::string> &Token::WgslReserved() {
+    static const std::vector<std::string> reserved(std::begin(kWgslReserved), std::end(kWgslReserved));
+    return reserved;
+}
+
+namespace {
+// Token::TokenEOF is always id 0. Types are added in TokenKind order, so a type's id is its
+// kind. Keywords and reserved words get consecutive ids, in order, starting after the tokens;
+// Token::findKeyword relies on this.
+std::vector<TokenType> makeTypes() {
+    std::vector<TokenType> types{Token::TokenEOF()};
+    const auto addType = [&](const std::string &name, const std::string &rule, bool isRegex) {
+        types.push_back({name, "token", rule, isRegex, static_cast<uint16_t>(types.size())});
+    };
+    for (const auto name: kWgslTokenNames) {
+        const std::string token(name);
+        const bool isRegex = token == "decimal_float_literal" || token == "hex_float_literal" ||
+                             token == "int_literal" || token == "uint_literal" || token == "ident";
+        addType(token, Token::WgslTokens().at(token), isRegex);
+    }
+    for (const auto &keyword: Token::WgslKeywords())
+        addType(keyword, keyword, false);
+    for (const auto &keyword: Token::WgslReserved())
+        addType(keyword, keyword, false);
+    return types;
+}
+
+std::unordered_map<std::string, TokenType> makeTokens() {
+    std::unordered_map<std::string, TokenType> tokens;
+    const auto &types = Token::Types();
+    for (size_t id = 1; id < kFirstKeyword; ++id)
+        tokens.emplace(types[id].name, types[id]);
+    return tokens;
+}
+
+std::unordered_map<std::string, TokenType> makeKeywords() {
+    std::unordered_map<std::string, TokenType> keywords;
+    const auto &types = Token::Types();
+    for (size_t id = kFirstKeyword; id < types.size(); ++id)
+        keywords.emplace(types[id].name, types[id]);
+    // Aliasing keywords that have different token names than the strings they represent.
+    for (const auto &alias: kKeywordAliases)
+        keywords.emplace(std::string(alias[0]), keywords.at(std::string(alias[1])));
+    return keywords;
+}
+}
+
+const std::vector<TokenType> &Token::Types() {
+    static const std::vector<TokenType> types = makeTypes();
+    return types;
+}
+
+const std::unordered_map<std::string, TokenType> &Token::Tokens() {
+    static const std::unordered_map<std::string, TokenType> tokens = makeTokens();
+    return tokens;
+}
+
+const std::unordered_map<std::string, TokenType> &Token::Keywords() {
+    static const std::unordered_map<std::string, TokenType> keywords = makeKeywords();
+    return keywords;
+}
+
+const TokenType *Token::findKeyword(std::string_view lexeme) {
+    const int keyword = kKeywordHash.find(lexeme);
+    if (keyword < 0)
+        return nullptr;
+    return &Token::Types()[kFirstKeyword + keyword];
+}
+
+Token::Token(TokenKind kind, size_t offset, size_t length, size_t line) :
+        _offset(static_cast<uint32_t>(offset)),
+        _line(static_cast<uint32_t>(line)),
+        _length(static_cast<uint16_t>(length)),
+        _kind(static_cast<uint16_t>(kind)),
+        _value{0} {
+    if (length > UINT16_MAX)
+        throw std::length_error("Token at line " + std::to_string(line) + " is too long");
+}
+
+Token::Token(const TokenType &type, size_t offset, size_t length, size_t line) :
+        Token(type.kind(), offset, length, line) {
+}
+
+static_assert(sizeof(Token) == 16, "Token is meant to stay a compact span into the source");
+
+//MARK: - WgslScanner
+namespace {
+enum CharClass : uint8_t {
+    kInvalid,
+    kWhitespace,
+    kNewline,
+    kAlpha,
+    kDigit,
+    kPunct,
 };
 
-std::unordered_map<std::string, TokenType> Token::Tokens{};
-std::unordered_map<std::string, TokenType> Token::Keywords{};
-
-std::unordered_map<std::string, TokenType> Token::StorageClass{};
-std::unordered_map<std::string, TokenType> Token::AccessMode{};
-std::unordered_map<std::string, TokenType> Token::SamplerType{};
-std::unordered_map<std::string, TokenType> Token::SampledTextureType{};
-std::unordered_map<std::string, TokenType> Token::MultisampledTextureType{};
-std::unordered_map<std::string, TokenType> Token::StorageTextureType{};
-std::unordered_map<std::string, TokenType> Token::DepthTextureType{};
-std::unordered_map<std::string, TokenType> Token::TextureType{};
-std::unordered_map<std::string, TokenType> Token::TexelFormat{};
-std::unordered_map<std::string, TokenType> Token::ConstLiteral{};
-std::unordered_map<std::string, TokenType> Token::LiteralOrIdent{};
-std::unordered_map<std::string, TokenType> Token::ElementCountExpression{};
-std::unordered_map<std::string, TokenType> Token::TemplateTypes{};
-std::unordered_map<std::string, TokenType> Token::AttributeName{};
-
-void Token::initialize() {
-    for (const auto &token: Token::WgslTokens) {
-        if (token.first == "decimal_float_literal" ||
-            token.first == "hex_float_literal" ||
-            token.first == "int_literal" ||
-            token.first == "uint_literal" ||
-            token.first == "ident") {
-            Token::Tokens[token.first] = TokenType{
-                    token.first,
-                    "token",
-                    token.second,
-                    true,
-            };
-        } else {
-            Token::Tokens[token.first] = TokenType{
-                    token.first,
-                    "token",
-                    token.second,
-                    false,
-            };
+struct CharTable {
+    uint8_t cls[256]{};
+    bool ident[256]{};
+    bool digit[256]{};
+    bool hex[256]{};
+
+    constexpr CharTable() {
+        cls[uint8_t(' ')] = kWhitespace;
+        cls[uint8_t('\t')] = kWhitespace;
+        cls[uint8_t('\r')] = kWhitespace;
+        cls[uint8_t('\n')] = kNewline;
+        for (int c = 'a'; c <= 'z'; ++c) {
+            cls[c] = kAlpha;
+            ident[c] = true;
+        }
+        for (int c = 'A'; c <= 'Z'; ++c) {
+            cls[c] = kAlpha;
+            ident[c] = true;
+        }
+        for (int c = '0'; c <= '9'; ++c) {
+            cls[c] = kDigit;
+            ident[c] = true;
+            digit[c] = true;
+            hex[c] = true;
+        }
+        for (int c = 'a'; c <= 'f'; ++c) {
+            hex[c] = true;
+            hex[c - 'a' + 'A'] = true;
+        }
+        ident[uint8_t('_')] = true;
+        const char punct[] = "&-@[]/!{}:,=<>%.+|();*~_^";
+        for (size_t i = 0; i + 1 < sizeof(punct); ++i) {
+            cls[uint8_t(punct[i])] = kPunct;
         }
     }
+};
 
-    for (const auto &keyword: Token::WgslKeywords) {
-        Token::Keywords[keyword] = TokenType{
-                keyword,
-                "token",
-                keyword,
-                false,
-        };
+constexpr CharTable kChars{};
+
+inline bool isDigit(char c) {
+    return kChars.digit[uint8_t(c)];
+}
+
+//MARK: - Whitespace and comment skipping
+inline uint32_t popcount(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return __popcnt(mask);
+#else
+    return __builtin_popcount(mask);
+#endif
+}
+
+inline uint32_t countTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// A block of source bytes compared against a character gives a bit mask with one bit per byte.
+#if defined(WGSL_SCANNER_AVX2)
+constexpr size_t kBlockSize = 32;
+constexpr uint32_t kFullBlock = 0xFFFFFFFFu;
+using Block = __m256i;
+
+inline Block loadBlock(const char *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+inline uint32_t matchMask(Block block, char c) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(c))));
+}
+#elif defined(WGSL_SCANNER_SSE2)
+constexpr size_t kBlockSize = 16;
+constexpr uint32_t kFullBlock = 0xFFFFu;
+using Block = __m128i;
+
+inline Block loadBlock(const char *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+inline uint32_t matchMask(Block block, char c) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c))));
+}
+#endif
+
+// Returns the position of the first character at or after pos that isn't ' ', '\t', '\r' or
+// '\n', adding the line-feeds skipped over to line.
+size_t skipWhitespace(std::string_view source, size_t pos, size_t &line) {
+    const char *data = source.data();
+    const size_t size = source.size();
+#if defined(WGSL_SCANNER_AVX2) || defined(WGSL_SCANNER_SSE2)
+    while (pos + kBlockSize <= size) {
+        const Block block = loadBlock(data + pos);
+        const uint32_t newlines = matchMask(block, '\n');
+        const uint32_t whitespace = newlines | matchMask(block, ' ') | matchMask(block, '\t') |
+                                    matchMask(block, '\r');
+        if (whitespace != kFullBlock) {
+            const uint32_t length = countTrailingZeros(~whitespace);
+            line += popcount(newlines & ((1u << length) - 1));
+            return pos + length;
+        }
+        line += popcount(newlines);
+        pos += kBlockSize;
     }
+#endif
+    for (; pos < size; ++pos) {
+        const auto cls = kChars.cls[uint8_t(data[pos])];
+        if (cls == kNewline)
+            line++;
+        else if (cls != kWhitespace)
+            break;
+    }
+    return pos;
+}
 
-    for (const auto &keyword: Token::WgslReserved) {
-        Token::Keywords[keyword] = TokenType{
-                keyword,
-                "token",
-                keyword,
-                false,
-        };
+// Skips the body of a block comment, allowing for nested block comments. pos is just after the
+// opening '/*'. Returns the position after the matching '*/', or the end of the source if the
+// comment isn't closed.
+size_t skipBlockComment(std::string_view source, size_t pos, size_t &line) {
+    const char *data = source.data();
+    const size_t size = source.size();
+    size_t commentLevel = 1;
+    while (pos < size) {
+#if defined(WGSL_SCANNER_AVX2) || defined(WGSL_SCANNER_SSE2)
+        // Only '*' and '/' can open or close a comment, jump to the next one of those.
+        while (pos + kBlockSize <= size) {
+            const Block block = loadBlock(data + pos);
+            const uint32_t newlines = matchMask(block, '\n');
+            const uint32_t stops = matchMask(block, '*') | matchMask(block, '/');
+            if (stops != 0) {
+                const uint32_t length = countTrailingZeros(stops);
+                line += popcount(newlines & ((1u << length) - 1));
+                pos += length;
+                break;
+            }
+            line += popcount(newlines);
+            pos += kBlockSize;
+        }
+        if (pos >= size)
+            break;
+#endif
+        const char c = data[pos++];
+        if (c == '\n') {
+            line++;
+        } else if (c == '*' && pos < size && data[pos] == '/') {
+            pos++;
+            if (--commentLevel == 0)
+                return pos;
+        } else if (c == '/' && pos < size && data[pos] == '*') {
+            pos++;
+            commentLevel++;
+        }
     }
+    return size;
+}
+}
 
-    // WGSL grammar has a few keywords that have different token names than the strings they
-    // represent. Aliasing them here.
-    Token::Keywords["int32"] = Token::Keywords["i32"];
-    Token::Keywords["uint32"] = Token::Keywords["u32"];
-    Token::Keywords["float32"] = Token::Keywords["f32"];
-    Token::Keywords["pointer"] = Token::Keywords["ptr"];
-
-    // The grammar has a few rules where the rule can match to any one of a given set of keywords
-    // or tokens. Defining those here.
-    Token::StorageClass["function"] = Token::Keywords["function"];
-    Token::StorageClass["private"] = Token::Keywords["private"];
-    Token::StorageClass["workgroup"] = Token::Keywords["workgroup"];
-    Token::StorageClass["uniform"] = Token::Keywords["uniform"];
-    Token::StorageClass["storage"] = Token::Keywords["storage"];
-
-    Token::AccessMode["read"] = Keywords["read"];
-    Token::AccessMode["write"] = Keywords["write"];
-    Token::AccessMode["read_write"] = Keywords["read_write"];
-
-    Token::SamplerType["sampler"] = Keywords["sampler"];
-    Token::SamplerType["sampler_comparison"] = Keywords["sampler_comparison"];
-
-    Token::SampledTextureType["texture_1d"] = Keywords["texture_1d"];
-    Token::SampledTextureType["texture_2d"] = Keywords["texture_2d"];
-    Token::SampledTextureType["texture_2d_array"] = Keywords["texture_2d_array"];
-    Token::SampledTextureType["texture_3d"] = Keywords["texture_3d"];
-    Token::SampledTextureType["texture_cube"] = Keywords["texture_cube"];
-    Token::SampledTextureType["texture_cube_array"] = Keywords["texture_cube_array"];
-    for (const auto &type: SampledTextureType) {
-        Token::TextureType[type.first] = type.second;
-    }
-
-    Token::MultisampledTextureType["texture_multisampled_2d"] = Keywords["texture_multisampled_2d"];
-    for (const auto &type: MultisampledTextureType) {
-        Token::TextureType[type.first] = type.second;
-    }
-
-    Token::StorageTextureType["texture_storage_1d"] = Keywords["texture_storage_1d"];
-    Token::StorageTextureType["texture_storage_2d"] = Keywords["texture_storage_2d"];
-    Token::StorageTextureType["texture_storage_2d_array"] = Keywords["texture_storage_2d_array"];
-    Token::StorageTextureType["texture_storage_3d"] = Keywords["texture_storage_3d"];
-    for (const auto &type: StorageTextureType) {
-        Token::TextureType[type.first] = type.second;
-    }
-
-    Token::DepthTextureType["texture_depth_2d"] = Keywords["texture_depth_2d"];
-    Token::DepthTextureType["texture_depth_2d_array"] = Keywords["texture_depth_2d_array"];
-    Token::DepthTextureType["texture_depth_cube"] = Keywords["texture_depth_cube"];
-    Token::DepthTextureType["texture_depth_cube_array"] = Keywords["texture_depth_cube_array"];
-    Token::DepthTextureType["texture_depth_multisampled_2d"] = Keywords["texture_depth_multisampled_2d"];
-    for (const auto &type: DepthTextureType) {
-        Token::TextureType[type.first] = type.second;
-    }
-
-    Token::TexelFormat["r8unorm"] = Keywords["r8unorm"];
-    Token::TexelFormat["r8snorm"] = Keywords["r8snorm"];
-    Token::TexelFormat["r8uint"] = Keywords["r8uint"];
-    Token::TexelFormat["r8sint"] = Keywords["r8sint"];
-    Token::TexelFormat["r16uint"] = Keywords["r16uint"];
-    Token::TexelFormat["r16sint"] = Keywords["r16sint"];
-    Token::TexelFormat["r16float"] = Keywords["r16float"];
-    Token::TexelFormat["rg8unorm"] = Keywords["rg8unorm"];
-    Token::TexelFormat["rg8snorm"] = Keywords["rg8snorm"];
-    Token::TexelFormat["rg8uint"] = Keywords["rg8uint"];
-    Token::TexelFormat["rg8sint"] = Keywords["rg8sint"];
-    Token::TexelFormat["r32uint"] = Keywords["r32uint"];
-    Token::TexelFormat["r32sint"] = Keywords["r32sint"];
-    Token::TexelFormat["r32float"] = Keywords["r32float"];
-    Token::TexelFormat["rg16uint"] = Keywords["rg16uint"];
-    Token::TexelFormat["rg16sint"] = Keywords["rg16sint"];
-    Token::TexelFormat["rg16float"] = Keywords["rg16float"];
-    Token::TexelFormat["rgba8unorm"] = Keywords["rgba8unorm"];
-    Token::TexelFormat["rgba8unorm_srgb"] = Keywords["rgba8unorm_srgb"];
-    Token::TexelFormat["rgba8snorm"] = Keywords["rgba8snorm"];
-    Token::TexelFormat["rgba8uint"] = Keywords["rgba8uint"];
-    Token::TexelFormat["rgba8sint"] = Keywords["rgba8sint"];
-    Token::TexelFormat["bgra8unorm"] = Keywords["bgra8unorm"];
-    Token::TexelFormat["bgra8unorm_srgb"] = Keywords["bgra8unorm_srgb"];
-    Token::TexelFormat["rgb10a2unorm"] = Keywords["rgb10a2unorm"];
-    Token::TexelFormat["rg11b10float"] = Keywords["rg11b10float"];
-    Token::TexelFormat["rg32uint"] = Keywords["rg32uint"];
-    Token::TexelFormat["rg32sint"] = Keywords["rg32sint"];
-    Token::TexelFormat["rg32float"] = Keywords["rg32float"];
-    Token::TexelFormat["rgba16uint"] = Keywords["rgba16uint"];
-    Token::TexelFormat["rgba16sint"] = Keywords["rgba16sint"];
-    Token::TexelFormat["rgba16float"] = Keywords["rgba16float"];
-    Token::TexelFormat["rgba32uint"] = Keywords["rgba32uint"];
-    Token::TexelFormat["rgba32sint"] = Keywords["rgba32sint"];
-    Token::TexelFormat["rgba32float"] = Keywords["rgba32float"];
-
-    Token::ConstLiteral["int_literal"] = Token::Tokens["int_literal"];
-    Token::ConstLiteral["uint_literal"] = Token::Tokens["uint_literal"];
-    Token::ConstLiteral["decimal_float_literal"] = Token::Tokens["decimal_float_literal"];
-    Token::ConstLiteral["hex_float_literal"] = Token::Tokens["hex_float_literal"];
-    Token::ConstLiteral["true"] = Keywords["true"];
-    Token::ConstLiteral["false"] = Keywords["false"];
-
-    Token::LiteralOrIdent["int_literal"] = Token::Tokens["int_literal"];
-    Token::LiteralOrIdent["uint_literal"] = Token::Tokens["uint_literal"];
-    Token::LiteralOrIdent["decimal_float_literal"] = Token::Tokens["decimal_float_literal"];
-    Token::LiteralOrIdent["hex_float_literal"] = Token::Tokens["hex_float_literal"];
-    Token::LiteralOrIdent["ident"] = Token::Tokens["ident"];
-
-    Token::ElementCountExpression["int_literal"] = Token::Tokens["int_literal"];
-    Token::ElementCountExpression["uint_literal"] = Token::Tokens["uint_literal"];
-    Token::ElementCountExpression["ident"] = Token::Tokens["ident"];
-
-    Token::TemplateTypes["vec2"] = Keywords["vec2"];
-    Token::TemplateTypes["vec3"] = Keywords["vec3"];
-    Token::TemplateTypes["vec4"] = Keywords["vec4"];
-    Token::TemplateTypes["mat2x2"] = Keywords["mat2x2"];
-    Token::TemplateTypes["mat2x3"] = Keywords["mat2x3"];
-    Token::TemplateTypes["mat2x4"] = Keywords["mat2x4"];
-    Token::TemplateTypes["mat3x2"] = Keywords["mat3x2"];
-    Token::TemplateTypes["mat3x3"] = Keywords["mat3x3"];
-    Token::TemplateTypes["mat3x4"] = Keywords["mat3x4"];
-    Token::TemplateTypes["mat4x2"] = Keywords["mat4x2"];
-    Token::TemplateTypes["mat4x3"] = Keywords["mat4x3"];
-    Token::TemplateTypes["mat4x4"] = Keywords["mat4x4"];
-    Token::TemplateTypes["atomic"] = Keywords["atomic"];
-    Token::TemplateTypes["bitcast"] = Keywords["bitcast"];
-    for (const auto &type: TextureType) {
-        Token::TemplateTypes[type.first] = type.second;
-    }
-
-    // The grammar calls out 'block', but attribute grammar is defined to use a 'ident'.
-    // The attribute grammar should be ident | block.
-    Token::AttributeName["ident"] = Token::Tokens["ident"];;
-    Token::AttributeName["block"] = Keywords["block"];
-}
-
-Token::Token(TokenType type, std::string lexeme, size_t line) :
-        _type(std::move(type)),
-        _lexeme(std::move(lexeme)),
-        _line(line) {
-}
-
-const std::string &Token::toString() {
-    return _lexeme;
+WgslScanner::WgslScanner(std::string source, Mode mode) :
+        WgslScanner(std::make_shared<const std::string>(std::move(source)), mode) {}
+
+WgslScanner::WgslScanner(const std::shared_ptr<const std::string> &source, Mode mode) :
+        WgslScanner(source, *source, mode) {}
+
+WgslScanner WgslScanner::fromMapped(std::shared_ptr<const MappedFile> file, Mode mode) {
+    const auto source = file->view();
+    return {std::move(file), source, mode};
 }
 
-//MARK: - WgslScanner
-WgslScanner::WgslScanner(std::string source) : _source(std::move(source)) {}
+WgslScanner WgslScanner::fromView(std::string_view source, Mode mode) {
+    return {nullptr, source, mode};
+}
+
+WgslScanner::WgslScanner(std::shared_ptr<const void> storage, std::string_view source, Mode mode) :
+        _storage(std::move(storage)),
+        _source(source),
+        _mode(mode) {
+    // Tokens address the source with 32 bit offsets.
+    if (_source.size() > UINT32_MAX)
+        throw std::length_error("WGSL source is too large to scan");
+}
 
 std::vector<Token> WgslScanner::scanTokens() {
     while (!_isAtEnd()) {
-        _start = _current;
-        if (!scanToken())
-            throw std::invalid_argument("Invalid syntax at line ${this._line}");
+        _scanNext();
+    }
+
+    _tokens.emplace_back(Token::TokenEOF(), _source.size(), 0, _line);
+    return std::move(_tokens);
+}
+
+Token WgslScanner::nextToken() {
+    // Only the most recent tokens are kept, for the '>>' lookback in _isTemplateClose.
+    if (_tokens.size() >= 2 * kTokenHistory)
+        _tokens.erase(_tokens.begin(), _tokens.end() - kTokenHistory);
+
+    const size_t count = _tokens.size();
+    while (!_isAtEnd() && _tokens.size() == count) {
+        _scanNext();
+    }
+
+    if (_tokens.size() == count)
+        return {Token::TokenEOF(), _source.size(), 0, _line};
+    return _tokens.back();
+}
+
+void WgslScanner::seek(size_t offset, size_t line) {
+    if (offset > _source.size())
+        throw std::out_of_range("Offset is outside of the source");
+    _current = offset;
+    _line = line;
+    _attrDepth = 0;
+    _tokens.clear();
+}
+
+void WgslScanner::rescan(std::string &source, std::vector<Token> &tokens, const Edit &edit,
+                         SymbolTable *symbols, Mode mode) {
+    if (edit.offset > source.size() || edit.removed > source.size() - edit.offset)
+        throw std::out_of_range("Edit is outside of the source");
+    if (tokens.empty())
+        throw std::invalid_argument("rescan needs the token stream of the source before the edit");
+
+    const size_t editEnd = edit.offset + edit.removed;
+    const size_t newEditEnd = edit.offset + edit.inserted.size();
+    const auto delta = static_cast<int64_t>(edit.inserted.size()) - static_cast<int64_t>(edit.removed);
+    source.replace(edit.offset, edit.removed, edit.inserted);
+
+    // Restart at the last token that ends before the edit. There is at least one character of
+    // whitespace or comment between it and the edit, so the edit can't extend it, and a token
+    // start is never inside a comment.
+    const auto eof = tokens.end() - 1;
+    const auto restart = std::partition_point(tokens.begin(), eof, [&](const Token &token) {
+        return size_t(token._offset) + token._length < edit.offset;
+    });
+    const bool fromStart = restart == tokens.begin();
+    const size_t first = fromStart ? 0 : restart - tokens.begin() - 1;
+
+    // Restore the scanner state at the restart point: line, open '[[' attribute lists, and the
+    // token history the '>>' lookback looks at.
+    WgslScanner scanner(nullptr, source, mode);
+    scanner._symbols = symbols;
+    if (!fromStart) {
+        scanner._current = tokens[first]._offset;
+        scanner._line = tokens[first]._line;
+    }
+    const auto attrDepth = [](const Token &token) {
+        return token.kind() == TokenKind::AttrLeft ? 1 : token.kind() == TokenKind::AttrRight ? -1 : 0;
+    };
+    int64_t depth = 0;
+    for (size_t i = 0; i < first; ++i)
+        depth += attrDepth(tokens[i]);
+    scanner._attrDepth = static_cast<size_t>(depth);
+    const size_t history = std::min(first, kTokenHistory);
+    scanner._tokens.assign(tokens.begin() + first - history, tokens.begin() + first);
+
+    // Scan until kTokenHistory new tokens in a row match old tokens past the edit, shifted by
+    // delta, with the same '[[' depth. From there on, scanning would produce the old tokens.
+    const size_t end = eof - tokens.begin();
+    size_t old = first;
+    int64_t oldDepth = depth;
+    size_t matched = 0;
+    size_t matchedNew = 0;
+    size_t matchedOld = 0;
+    int64_t lineDelta = 0;
+    bool synced = false;
+    while (!synced && !scanner._isAtEnd()) {
+        const size_t count = scanner._tokens.size();
+        scanner._scanNext();
+        if (scanner._tokens.size() == count)
+            continue;
+        const Token &token = scanner._tokens.back();
+        if (token._offset < newEditEnd)
+            continue;
+
+        // Old tokens overlapping the edit can't match anything.
+        const auto shifted = [&](const Token &t) {
+            return t._offset >= editEnd ? static_cast<int64_t>(t._offset) + delta : -1;
+        };
+        while (old < end && shifted(tokens[old]) < static_cast<int64_t>(token._offset)) {
+            oldDepth += attrDepth(tokens[old++]);
+            matched = 0;
+        }
+        if (old == end)
+            continue;
+
+        const Token &previous = tokens[old];
+        if (shifted(previous) != static_cast<int64_t>(token._offset) || previous._kind != token._kind ||
+            previous._length != token._length ||
+            (matched > 0 && static_cast<int64_t>(token._line) - previous._line != lineDelta)) {
+            matched = 0;
+            continue;
+        }
+        if (matched == 0) {
+            matchedNew = scanner._tokens.size() - 1;
+            matchedOld = old;
+            lineDelta = static_cast<int64_t>(token._line) - previous._line;
+        }
+        matched++;
+        oldDepth += attrDepth(tokens[old++]);
+        synced = matched == kTokenHistory && oldDepth == static_cast<int64_t>(scanner._attrDepth);
     }
 
-    _tokens.emplace_back(Token::TokenEOF, "", _line);
-    return _tokens;
+    const auto scanned = scanner._tokens.begin() + history;
+    if (!synced) {
+        tokens.erase(tokens.begin() + first, tokens.end());
+        tokens.insert(tokens.end(), scanned, scanner._tokens.end());
+        tokens.emplace_back(Token::TokenEOF(), source.size(), 0, scanner._line);
+        return;
+    }
+
+    tokens.erase(tokens.begin() + first, tokens.begin() + matchedOld);
+    tokens.insert(tokens.begin() + first, scanned, scanner._tokens.begin() + matchedNew);
+    for (size_t i = first + (matchedNew - history); i < tokens.size(); ++i) {
+        tokens[i]._offset = static_cast<uint32_t>(tokens[i]._offset + delta);
+        tokens[i]._line = static_cast<uint32_t>(tokens[i]._line + lineDelta);
+    }
+}
+
+void WgslScanner::_scanNext() {
+    _start = _current;
+    const bool scanned = _mode == Mode::Legacy ? scanTokenLegacy() : scanToken();
+    if (!scanned) {
+        // Skip the whole character, not just the first byte of its UTF-8 sequence.
+        _current = _start + 1;
+        while (_current < _source.size() && (uint8_t(_source[_current]) & 0xC0) == 0x80)
+            _current++;
+        const auto character = _source.substr(_start, _current - _start);
+        _error(Diagnostic::Kind::InvalidCharacter, "Invalid character '" + std::string(character) + "'.");
+        return;
+    }
+    if (_mode == Mode::Legacy)
+        _finishLegacyToken();
 }
 
 bool WgslScanner::scanToken() {
+    const char c = _source[_current++];
+    switch (kChars.cls[uint8_t(c)]) {
+        case kNewline:
+            _line++;
+            _current = skipWhitespace(_source, _current, _line);
+            return true;
+        case kWhitespace:
+            _current = skipWhitespace(_source, _current, _line);
+            return true;
+        case kAlpha:
+            _scanIdentifier();
+            return true;
+        case kDigit:
+            _scanNumber(c);
+            return true;
+        case kPunct:
+            break;
+        default:
+            return false;
+    }
+
+    const char next = _current < _source.size() ? _source[_current] : '\0';
+    switch (c) {
+        case '/':
+            if (next == '/' || next == '*')
+                return _skipComment();
+            _addToken(TokenKind::ForwardSlash);
+            return true;
+        case '.':
+            if (isDigit(next)) {
+                _scanNumber(c);
+            } else {
+                _addToken(TokenKind::Period);
+            }
+            return true;
+        case '&':
+            if (next == '&') {
+                _current++;
+                _addToken(TokenKind::AndAnd);
+            } else {
+                _addToken(TokenKind::And);
+            }
+            return true;
+        case '|':
+            if (next == '|') {
+                _current++;
+                _addToken(TokenKind::OrOr);
+            } else {
+                _addToken(TokenKind::Or);
+            }
+            return true;
+        case '-':
+            // Unlike the legacy rules, a sign is never folded into a numeric literal: a-1 is
+            // ident, minus, int_literal and the parser handles negation as a unary operator.
+            if (next == '>') {
+                _current++;
+                _addToken(TokenKind::Arrow);
+            } else if (next == '-') {
+                _current++;
+                _addToken(TokenKind::MinusMinus);
+            } else {
+                _addToken(TokenKind::Minus);
+            }
+            return true;
+        case '+':
+            if (next == '+') {
+                _current++;
+                _addToken(TokenKind::PlusPlus);
+            } else {
+                _addToken(TokenKind::Plus);
+            }
+            return true;
+        case '=':
+            if (next == '=') {
+                _current++;
+                _addToken(TokenKind::EqualEqual);
+            } else {
+                _addToken(TokenKind::Equal);
+            }
+            return true;
+        case '!':
+            if (next == '=') {
+                _current++;
+                _addToken(TokenKind::NotEqual);
+            } else {
+                _addToken(TokenKind::Bang);
+            }
+            return true;
+        case '<':
+            if (next == '=') {
+                _current++;
+                _addToken(TokenKind::LessThanEqual);
+            } else if (next == '<') {
+                _current++;
+                _addToken(TokenKind::ShiftLeft);
+            } else {
+                _addToken(TokenKind::LessThan);
+            }
+            return true;
+        case '>':
+            if (next == '=') {
+                _current++;
+                _addToken(TokenKind::GreaterThanEqual);
+            } else if (next == '>' && !_isTemplateClose()) {
+                _current++;
+                _addToken(TokenKind::ShiftRight);
+            } else {
+                _addToken(TokenKind::GreaterThan);
+            }
+            return true;
+        case '[':
+            if (next == '[') {
+                _current++;
+                _attrDepth++;
+                _addToken(TokenKind::AttrLeft);
+            } else {
+                _addToken(TokenKind::BracketLeft);
+            }
+            return true;
+        case ']':
+            // ']]' only closes an attribute list when one is open, so a[b[0]] still
+            // scans as two bracket_right's.
+            if (next == ']' && _attrDepth > 0) {
+                _current++;
+                _attrDepth--;
+                _addToken(TokenKind::AttrRight);
+            } else {
+                _addToken(TokenKind::BracketRight);
+            }
+            return true;
+        case '@':
+            _addToken(TokenKind::Attr);
+            return true;
+        case '{':
+            _addToken(TokenKind::BraceLeft);
+            return true;
+        case '}':
+            _addToken(TokenKind::BraceRight);
+            return true;
+        case '(':
+            _addToken(TokenKind::ParenLeft);
+            return true;
+        case ')':
+            _addToken(TokenKind::ParenRight);
+            return true;
+        case ':':
+            _addToken(TokenKind::Colon);
+            return true;
+        case ';':
+            _addToken(TokenKind::Semicolon);
+            return true;
+        case ',':
+            _addToken(TokenKind::Comma);
+            return true;
+        case '%':
+            _addToken(TokenKind::Modulo);
+            return true;
+        case '*':
+            _addToken(TokenKind::Star);
+            return true;
+        case '~':
+            _addToken(TokenKind::Tilde);
+            return true;
+        case '^':
+            _addToken(TokenKind::Xor);
+            return true;
+        case '_':
+            // Identifiers must start with a letter, so a leading '_' is always its own token.
+            _addToken(TokenKind::Underscore);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool WgslScanner::_skipComment() {
+    // _current is on the second character of '//' or '/*'.
+    if (_source[_current] == '/') {
+        // memchr is vectorized by the C library.
+        const auto *end = static_cast<const char *>(
+                std::memchr(_source.data() + _current, '\n', _source.size() - _current));
+        if (end == nullptr) {
+            _current = _source.size();
+        } else {
+            // skip the linefeed
+            _current = end - _source.data() + 1;
+            _line++;
+        }
+        return true;
+    }
+
+    _current = skipBlockComment(_source, _current + 1, _line);
+    return true;
+}
+
+void WgslScanner::_scanIdentifier() {
+    const size_t size = _source.size();
+    while (_current < size && kChars.ident[uint8_t(_source[_current])])
+        _current++;
+
+    const auto keyword = Token::findKeyword(_source.substr(_start, _current - _start));
+    if (keyword) {
+        _addToken(*keyword);
+    } else {
+        _addToken(TokenKind::Ident);
+        if (_symbols)
+            _tokens.back()._value.u = _symbols->intern(_source.substr(_start, _current - _start))->id;
+    }
+}
+
+void WgslScanner::_scanNumber(char c) {
+    // Implements the ident/int/uint/float/hex-float rules of Token::WgslTokens, minus the
+    // optional leading '-'. Where a rule can't complete, the longest valid prefix is taken,
+    // like the legacy scanner does. Integer values are accumulated while the digits are
+    // scanned; float values are decoded from the recognized digits.
+    const size_t size = _source.size();
+    const auto peek = [&](size_t offset) {
+        return _current + offset < size ? _source[_current + offset] : '\0';
+    };
+    // Anything above UINT32_MAX is out of range for every literal, so the accumulator just
+    // has to stay above it once it gets there.
+    uint64_t integer = 0;
+    const auto skipDigits = [&](const bool *table, unsigned base) {
+        size_t count = 0;
+        while (_current < size && table[uint8_t(_source[_current])]) {
+            const char d = _source[_current];
+            const unsigned digit = d <= '9' ? d - '0' : (d | 0x20) - 'a' + 10;
+            integer = std::min<uint64_t>(integer * base + digit, uint64_t(UINT32_MAX) + 1);
+            _current++;
+            count++;
+        }
+        return count;
+    };
+    // An exponent is only taken when it is followed by at least one digit.
+    const auto skipExponent = [&](char e0, char e1) {
+        const char e = peek(0);
+        if (e != e0 && e != e1)
+            return false;
+        size_t offset = 1;
+        if (peek(offset) == '+' || peek(offset) == '-')
+            offset++;
+        if (!isDigit(peek(offset)))
+            return false;
+        _current += offset;
+        skipDigits(kChars.digit, 10);
+        return true;
+    };
+    const auto addFloat = [&](TokenKind kind, size_t digitsStart, bool hex) {
+        const auto digits = _source.substr(digitsStart, _current - digitsStart);
+        const uint32_t bits = _decodeFloat(digits, hex);
+        if (peek(0) == 'f')
+            _current++;
+        _addNumber(kind, bits);
+    };
+    // A negated int_literal can be as low as INT32_MIN, so 2^31 itself is let through here.
+    const auto addInteger = [&]() {
+        if (peek(0) == 'u') {
+            _current++;
+            if (integer > UINT32_MAX)
+                _error(Diagnostic::Kind::LiteralOutOfRange, "uint literal out of range.");
+            _addNumber(TokenKind::UintLiteral, static_cast<uint32_t>(integer));
+        } else {
+            if (integer > uint64_t(INT32_MAX) + 1)
+                _error(Diagnostic::Kind::LiteralOutOfRange, "int literal out of range.");
+            _addNumber(TokenKind::IntLiteral, static_cast<uint32_t>(integer));
+        }
+    };
+
+    if (c == '0' && peek(0) == 'x') {
+        _current++;
+        const size_t whole = skipDigits(kChars.hex, 16);
+        size_t fraction = 0;
+        bool isFloat = false;
+        if (peek(0) == '.' && (whole > 0 || kChars.hex[uint8_t(peek(1))])) {
+            _current++;
+            fraction = skipDigits(kChars.hex, 16);
+            isFloat = true;
+        }
+        if (whole > 0 || fraction > 0) {
+            // Stops before a 'f' suffix; 'f' is a hex digit, so it only is a suffix after an
+            // exponent.
+            if (skipExponent('p', 'P'))
+                isFloat = true;
+            if (isFloat) {
+                addFloat(TokenKind::HexFloatLiteral, _start + 2, true);
+                return;
+            }
+            addInteger();
+            return;
+        }
+        // '0x' on its own: only the '0' is a literal.
+        _current = _start + 1;
+        _addNumber(TokenKind::IntLiteral, 0);
+        return;
+    }
+
+    integer = c == '.' ? 0 : c - '0';
+    bool isFloat = c == '.';
+    skipDigits(kChars.digit, 10);
+    if (!isFloat && peek(0) == '.') {
+        _current++;
+        skipDigits(kChars.digit, 10);
+        isFloat = true;
+    }
+    if (skipExponent('e', 'E'))
+        isFloat = true;
+
+    if (isFloat) {
+        addFloat(TokenKind::DecimalFloatLiteral, _start, false);
+        return;
+    }
+
+    // Integers don't have leading zeros; '0' is a literal on its own.
+    if (c == '0') {
+        _current = _start + 1;
+        integer = 0;
+    }
+    addInteger();
+}
+
+void WgslScanner::_addNumber(TokenKind kind, uint32_t bits) {
+    _addToken(kind);
+    _tokens.back()._value.u = bits;
+}
+
+uint32_t WgslScanner::_decodeFloat(std::string_view digits, bool hex) const {
+    float value = 0.0f;
+    bool decoded = false;
+#if defined(__cpp_lib_to_chars)
+    const auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value,
+                                        hex ? std::chars_format::hex : std::chars_format::general);
+    decoded = result.ec == std::errc();
+#endif
+    if (!decoded) {
+        // from_chars doesn't tell an overflow from an underflow; strtof does.
+        std::string text = hex ? "0x" : "";
+        text.append(digits);
+        value = std::strtof(text.c_str(), nullptr);
+    }
+    if (std::isinf(value))
+        _error(Diagnostic::Kind::LiteralOutOfRange, "float literal out of range.");
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void WgslScanner::_finishLegacyToken() {
+    if (_tokens.empty() || _tokens.back()._offset != _start)
+        return;
+    Token &token = _tokens.back();
+    auto lexeme = token.lexeme(_source);
+    const bool negative = !lexeme.empty() && lexeme[0] == '-';
+    if (negative)
+        lexeme.remove_prefix(1);
+
+    const auto kind = token.kind();
+    if (kind == TokenKind::Ident) {
+        if (_symbols)
+            token._value.u = _symbols->intern(lexeme)->id;
+    } else if (kind == TokenKind::IntLiteral || kind == TokenKind::UintLiteral) {
+        const bool hex = lexeme.size() > 1 && lexeme[1] == 'x';
+        if (hex)
+            lexeme.remove_prefix(2);
+        if (!lexeme.empty() && lexeme.back() == 'u')
+            lexeme.remove_suffix(1);
+        uint32_t value = 0;
+        const auto result = std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value, hex ? 16 : 10);
+        if (result.ec != std::errc())
+            _error(Diagnostic::Kind::LiteralOutOfRange, "Integer literal out of range.");
+        token._value.u = negative ? 0u - value : value;
+    } else if (kind == TokenKind::DecimalFloatLiteral || kind == TokenKind::HexFloatLiteral) {
+        const bool hex = kind == TokenKind::HexFloatLiteral;
+        if (hex)
+            lexeme.remove_prefix(2);
+        if (!lexeme.empty() && lexeme.back() == 'f' && !hex)
+            lexeme.remove_suffix(1);
+        if (hex && lexeme.find_first_of("pP") != std::string_view::npos && lexeme.back() == 'f')
+            lexeme.remove_suffix(1);
+        token._value.u = _decodeFloat(lexeme, hex);
+        if (negative)
+            token._value.f = -token._value.f;
+    }
+}
+
+void WgslScanner::_error(Diagnostic::Kind kind, const std::string &message) const {
+    Diagnostic diagnostic(kind, message, _source, _start, _current - _start, _line);
+    if (!_diagnostics)
+        throw std::invalid_argument(diagnostic.toString());
+    _diagnostics->push_back(std::move(diagnostic));
+}
+
+bool WgslScanner::_isTemplateClose() {
+    // The exception to "longest lexeme" rule is '>>'. In the case of 1>>2, it's a shift_right.
+    // In the case of array<vec4<f32>>, it's two greater_than's (one to close the vec4,
+    // and one to close the array).
+    // If there was a less_than up to some number of tokens previously, and the token prior to
+    // that is a keyword that requires a '<', then it will be split into two greater_than's;
+    // otherwise it's a shift_right.
+    auto ti = static_cast<std::ptrdiff_t>(_tokens.size()) - 1;
+    for (size_t count = 0; count < 4 && ti >= 0; ++count, --ti) {
+        if (_tokens[ti].kind() == TokenKind::LessThan) {
+            return ti > 0 && Token::TemplateTypes.contains(_tokens[ti - 1].kind());
+        }
+    }
+    return false;
+}
+
+bool WgslScanner::scanTokenLegacy() {
     // Find the longest consecutive set of characters that match a rule.
     auto lexeme = _advance();
 
@@ -466,28 +1094,11 @@ bool WgslScanner::scanToken() {
     for (;;) {
         auto matchedToken = _findToken(lexeme);
 
-        // The exception to "longest lexeme" rule is '>>'. In the case of 1>>2, it's a shift_right.
-        // In the case of array<vec4<f32>>, it's two greater_than's (one to close the vec4,
-        // and one to close the array).
-        // I don't know of a great way to resolve this, so '>>' is special-cased and if
-        // there was a less_than up to some number of tokens previously, and the token prior to
-        // that is a keyword that requires a '<', then it will be split into two greater_than's;
-        // otherwise it's a shift_right.
+        // See _isTemplateClose for the '>>' special case.
         if (lexeme == ">" && _peekAhead() == ">") {
-            bool foundLessThan = false;
-            size_t ti = _tokens.size() - 1;
-            for (size_t count = 0; count < 4 && ti >= 0; ++count, --ti) {
-                if (_tokens[ti]._type == Token::Tokens["less_than"]) {
-                    const auto iter = Token::TemplateTypes.find(_tokens[ti - 1]._type.name);
-                    if (ti > 0 && iter != Token::TemplateTypes.end()) {
-                        foundLessThan = true;
-                    }
-                    break;
-                }
-            }
             // If there was a less_than in the recent token history, then this is probably a
             // greater_than.
-            if (foundLessThan) {
+            if (_isTemplateClose()) {
                 _addToken(matchedToken.value());
                 return true;
             }
@@ -543,12 +1154,12 @@ bool WgslScanner::scanToken() {
 }
 
 std::optional<TokenType> WgslScanner::_findToken(const std::string &lexeme) {
-    for (const auto &name: Token::Keywords) {
+    for (const auto &name: Token::Keywords()) {
         if (_match(lexeme, name.second.rule)) {
             return name.second;
         }
     }
-    for (const auto &name: Token::Tokens) {
+    for (const auto &name: Token::Tokens()) {
         if (name.second.isRegex) {
             if (_match(lexeme, std::regex(name.second.rule))) {
                 return name.second;
@@ -570,7 +1181,8 @@ bool WgslScanner::_match(const std::string &lexeme, const std::string &rule) {
 }
 
 bool WgslScanner::_match(const std::string &lexeme, const std::regex &rule) {
-    if (std::regex_search(lexeme, rule))
+    // The rule has to match the whole lexeme, not just a part of it.
+    if (std::regex_match(lexeme, rule))
         return true;
     return false;
 }
@@ -584,7 +1196,7 @@ bool WgslScanner::_isWhitespace(const std::string &c) {
 }
 
 std::string WgslScanner::_advance(size_t amount) {
-    const auto &c = _source.substr(_current);
+    const auto c = std::string(_source.substr(_current, 1));
     amount++;
     _current += amount;
     return c;
@@ -592,10 +1204,13 @@ std::string WgslScanner::_advance(size_t amount) {
 
 std::string WgslScanner::_peekAhead(size_t offset) {
     if (_current + offset >= _source.size()) return "\0";
-    return _source.substr(_current + offset);
+    return std::string(_source.substr(_current + offset, 1));
 }
 
 void WgslScanner::_addToken(const TokenType &type) {
-    const auto &text = _source.substr(_start, _current - _start);
-    _tokens.emplace_back(type, text, _line);
-}
\ No newline at end of file
+    _tokens.emplace_back(type, _start, _current - _start, _line);
+}
+
+void WgslScanner::_addToken(TokenKind kind) {
+    _tokens.emplace_back(kind, _start, _current - _start, _line);
+}
@@ -7,16 +7,32 @@
 #ifndef WGSL_INTROSPECTOR_WGSL_SCANNER_H
 #define WGSL_INTROSPECTOR_WGSL_SCANNER_H
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <optional>
 #include <regex>
 #include <utility>
+#include <vector>
+#include "wgsl_diagnostic.h"
+#include "wgsl_token_kinds.h"
+
+class MappedFile;
+class SymbolTable;
 
 struct TokenType {
     std::string name;
     std::string type;
     std::string rule;
     bool isRegex;
+    // Index into Token::Types. Aliases share the id of the
+    // keyword they alias.
+    uint16_t id = 0;
+
+    [[nodiscard]] TokenKind kind() const {
+        return static_cast<TokenKind>(id);
+    }
 
     bool operator==(TokenType& t) const {
         return name == t.name;
@@ -29,54 +45,243 @@ struct TokenType {
 
 class Token {
 public:
-    static const TokenType TokenEOF;
-    static const std::unordered_map<std::string, std::string> WgslTokens;
-    static const std::vector<std::string> WgslKeywords;
-    static const std::vector<std::string> WgslReserved;
-
-    static std::unordered_map<std::string, TokenType> Tokens;
-    static std::unordered_map<std::string, TokenType> Keywords;
-
-    static std::unordered_map<std::string, TokenType> StorageClass;
-    static std::unordered_map<std::string, TokenType> AccessMode;
-    static std::unordered_map<std::string, TokenType> SamplerType;
-    static std::unordered_map<std::string, TokenType> SampledTextureType;
-    static std::unordered_map<std::string, TokenType> MultisampledTextureType;
-    static std::unordered_map<std::string, TokenType> StorageTextureType;
-    static std::unordered_map<std::string, TokenType> DepthTextureType;
-    static std::unordered_map<std::string, TokenType> TextureType;
-    static std::unordered_map<std::string, TokenType> TexelFormat;
-    static std::unordered_map<std::string, TokenType> ConstLiteral;
-    static std::unordered_map<std::string, TokenType> LiteralOrIdent;
-    static std::unordered_map<std::string, TokenType> ElementCountExpression;
-    static std::unordered_map<std::string, TokenType> TemplateTypes;
-    static std::unordered_map<std::string, TokenType> AttributeName;
-
-    static void initialize();
+    // The tables are built on first use, once, even when several threads get there at the same
+    // time, and never change after, so any number of threads can scan and parse at once. Being
+    // function statics, they are also there for code that scans during static initialization.
+    static const TokenType &TokenEOF();
+    static const std::unordered_map<std::string, std::string> &WgslTokens();
+    static const std::vector<std::string> &WgslKeywords();
+    static const std::vector<std::string> &WgslReserved();
+
+    // Every token type, indexed by TokenType::id.
+    static const std::vector<TokenType> &Types();
+    static const std::unordered_map<std::string, TokenType> &Tokens();
+    static const std::unordered_map<std::string, TokenType> &Keywords();
+
+    // The grammar has a few rules where the rule can match to any one of a given set of keywords
+    // or tokens.
+    static constexpr TokenKindSet StorageClass{
+            TokenKind::Function, TokenKind::Private, TokenKind::Workgroup, TokenKind::Uniform,
+            TokenKind::Storage};
+    static constexpr TokenKindSet AccessMode{TokenKind::Read, TokenKind::Write, TokenKind::ReadWrite};
+    static constexpr TokenKindSet SamplerType{TokenKind::Sampler, TokenKind::SamplerComparison};
+    static constexpr TokenKindSet SampledTextureType{
+            TokenKind::Texture1d, TokenKind::Texture2d, TokenKind::Texture2dArray, TokenKind::Texture3d,
+            TokenKind::TextureCube, TokenKind::TextureCubeArray};
+    static constexpr TokenKindSet MultisampledTextureType{TokenKind::TextureMultisampled2d};
+    static constexpr TokenKindSet StorageTextureType{
+            TokenKind::TextureStorage1d, TokenKind::TextureStorage2d, TokenKind::TextureStorage2dArray,
+            TokenKind::TextureStorage3d};
+    static constexpr TokenKindSet DepthTextureType{
+            TokenKind::TextureDepth2d, TokenKind::TextureDepth2dArray, TokenKind::TextureDepthCube,
+            TokenKind::TextureDepthCubeArray, TokenKind::TextureDepthMultisampled2d};
+    static constexpr TokenKindSet TextureType =
+            SampledTextureType | MultisampledTextureType | StorageTextureType | DepthTextureType;
+    static constexpr TokenKindSet TexelFormat{
+            TokenKind::R8unorm, TokenKind::R8snorm, TokenKind::R8uint, TokenKind::R8sint, TokenKind::R16uint,
+            TokenKind::R16sint, TokenKind::R16float, TokenKind::Rg8unorm, TokenKind::Rg8snorm,
+            TokenKind::Rg8uint, TokenKind::Rg8sint, TokenKind::R32uint, TokenKind::R32sint,
+            TokenKind::R32float, TokenKind::Rg16uint, TokenKind::Rg16sint, TokenKind::Rg16float,
+            TokenKind::Rgba8unorm, TokenKind::Rgba8unormSrgb, TokenKind::Rgba8snorm, TokenKind::Rgba8uint,
+            TokenKind::Rgba8sint, TokenKind::Bgra8unorm, TokenKind::Bgra8unormSrgb, TokenKind::Rgb10a2unorm,
+            TokenKind::Rg11b10float, TokenKind::Rg32uint, TokenKind::Rg32sint, TokenKind::Rg32float,
+            TokenKind::Rgba16uint, TokenKind::Rgba16sint, TokenKind::Rgba16float, TokenKind::Rgba32uint,
+            TokenKind::Rgba32sint, TokenKind::Rgba32float};
+    static constexpr TokenKindSet ConstLiteral{
+            TokenKind::IntLiteral, TokenKind::UintLiteral, TokenKind::DecimalFloatLiteral,
+            TokenKind::HexFloatLiteral, TokenKind::True, TokenKind::False};
+    static constexpr TokenKindSet LiteralOrIdent{
+            TokenKind::IntLiteral, TokenKind::UintLiteral, TokenKind::DecimalFloatLiteral,
+            TokenKind::HexFloatLiteral, TokenKind::Ident};
+    static constexpr TokenKindSet ElementCountExpression{
+            TokenKind::IntLiteral, TokenKind::UintLiteral, TokenKind::Ident};
+    static constexpr TokenKindSet TemplateTypes = TokenKindSet{
+            TokenKind::Vec2, TokenKind::Vec3, TokenKind::Vec4, TokenKind::Mat2x2, TokenKind::Mat2x3,
+            TokenKind::Mat2x4, TokenKind::Mat3x2, TokenKind::Mat3x3, TokenKind::Mat3x4, TokenKind::Mat4x2,
+            TokenKind::Mat4x3, TokenKind::Mat4x4, TokenKind::Atomic, TokenKind::Bitcast} |
+            SampledTextureType | MultisampledTextureType | StorageTextureType;
+    // The grammar calls out 'block', but attribute grammar is defined to use a 'ident'.
+    // The attribute grammar should be ident | block.
+    static constexpr TokenKindSet AttributeName{TokenKind::Ident, TokenKind::Block};
+
+    // Classifies an identifier with one probe of a compile time perfect hash. Aliases such as
+    // int32 resolve to the keyword they alias. Returns nullptr for plain identifiers.
+    static const TokenType *findKeyword(std::string_view lexeme);
 
 public:
-    Token(TokenType type, std::string lexeme, size_t line);
+    Token() = default;
+
+    Token(const TokenType &type, size_t offset, size_t length, size_t line);
+
+    Token(TokenKind kind, size_t offset, size_t length, size_t line);
+
+    [[nodiscard]] const TokenType &type() const {
+        return Types()[_kind];
+    }
 
-    const std::string &toString();
+    [[nodiscard]] TokenKind kind() const {
+        return static_cast<TokenKind>(_kind);
+    }
+
+    [[nodiscard]] size_t line() const {
+        return _line;
+    }
+
+    // A token doesn't own its text, it is a span of the source it was scanned from.
+    // The source has to be kept alive by the caller.
+    std::string_view lexeme(std::string_view source) const {
+        return source.substr(_offset, _length);
+    }
+
+    std::string toString(std::string_view source) const {
+        return std::string(lexeme(source));
+    }
+
+    // The value of an int_literal, uint_literal or float literal token, decoded by the scanner.
+    // Meaningless for any other token, whose kind has to be checked first: an ident keeps the id
+    // of its symbol in the same place.
+    [[nodiscard]] int32_t intValue() const {
+        return _value.i;
+    }
+
+    [[nodiscard]] uint32_t uintValue() const {
+        return _value.u;
+    }
+
+    [[nodiscard]] float floatValue() const {
+        return _value.f;
+    }
+
+    // The id of an ident token's symbol, when it was scanned with a symbol table, 0 otherwise.
+    [[nodiscard]] uint32_t symbolId() const {
+        return _value.u;
+    }
 
 private:
     friend class WgslScanner;
     friend class WgslParser;
+    friend class AstSerializer;
+
+    uint32_t _offset;
+    uint32_t _line;
+    uint16_t _length;
+    uint16_t _kind;
+    union {
+        int32_t i;
+        uint32_t u;
+        float f;
+    } _value;
+};
+
+//MARK: - TokenSpan
+// A borrowed, read-only view of a token buffer, so tokens can be handed around without
+// copying them. The buffer has to outlive the span.
+class TokenSpan {
+public:
+    TokenSpan() = default;
+
+    TokenSpan(const Token *data, size_t size) : _data(data), _size(size) {
+    }
+
+    TokenSpan(const std::vector<Token> &tokens) : _data(tokens.data()), _size(tokens.size()) {
+    }
+
+    [[nodiscard]] const Token &operator[](size_t index) const {
+        return _data[index];
+    }
+
+    [[nodiscard]] const Token *data() const {
+        return _data;
+    }
 
-    TokenType _type;
-    std::string _lexeme;
-    size_t _line;
+    [[nodiscard]] size_t size() const {
+        return _size;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _size == 0;
+    }
+
+    [[nodiscard]] const Token *begin() const {
+        return _data;
+    }
+
+    [[nodiscard]] const Token *end() const {
+        return _data + _size;
+    }
+
+private:
+    const Token *_data = nullptr;
+    size_t _size = 0;
 };
 
 //MARK: - WgslScanner
 class WgslScanner {
 public:
-    explicit WgslScanner(std::string source);
+    enum class Mode {
+        // Single pass state machine driven by a character class table.
+        StateMachine,
+        // The original rule scanner, which grows the lexeme one character at a time and
+        // tests it against every keyword and token rule. Kept so the token streams of the
+        // two scanners can be diffed.
+        Legacy
+    };
+
+    explicit WgslScanner(std::string source, Mode mode = Mode::StateMachine);
+
+    // Scans straight from a mapped file, without copying it. The scanner keeps the mapping alive.
+    static WgslScanner fromMapped(std::shared_ptr<const MappedFile> file, Mode mode = Mode::StateMachine);
+
+    // Scans source in place, without copying or owning it. source has to outlive the scanner, and
+    // whatever is parsed from it.
+    static WgslScanner fromView(std::string_view source, Mode mode = Mode::StateMachine);
 
     std::vector<Token> scanTokens();
 
+    // Pulls the next token, for consumers that don't need the whole token stream at once. Only
+    // the last few tokens are kept. Returns a Token::TokenEOF() token once the source is consumed.
+    // Don't mix with scanTokens on the same scanner.
+    Token nextToken();
+
+    [[nodiscard]] std::string_view source() const {
+        return _source;
+    }
+
+    // Interns identifiers into symbols, which ident tokens then carry the id of. The table has
+    // to outlive the scanner.
+    void setSymbolTable(SymbolTable *symbols) {
+        _symbols = symbols;
+    }
+
+    // Collects errors in diagnostics, and scans on past them, instead of throwing on the first
+    // one: invalid characters are skipped, and out of range literals are still added. The list
+    // has to outlive the scanner.
+    void setDiagnostics(std::vector<Diagnostic> *diagnostics) {
+        _diagnostics = diagnostics;
+    }
+
+    // Restarts scanning at offset, which has to be the start of a token on line, outside of any
+    // '[[' attribute list. Tokens before offset aren't looked back at.
+    void seek(size_t offset, size_t line);
+
+    // An edit of a source: removed characters at offset are replaced with inserted.
+    struct Edit {
+        size_t offset;
+        size_t removed;
+        std::string_view inserted;
+    };
+
+    // Applies edit to source and updates tokens, the complete token stream of source before the
+    // edit, to match. Only the part of the source from the last token before the edit up to where
+    // the new tokens line up with the old ones again is re-scanned; the offsets and lines of the
+    // tokens after that are shifted.
+    static void rescan(std::string &source, std::vector<Token> &tokens, const Edit &edit,
+                       SymbolTable *symbols = nullptr, Mode mode = Mode::StateMachine);
+
     bool scanToken();
 
+    bool scanTokenLegacy();
+
     static std::optional<TokenType> _findToken(const std::string &lexeme);
 
     static bool _match(const std::string &lexeme, const std::string &rule);
@@ -93,12 +298,49 @@ public:
 
     void _addToken(const TokenType &type);
 
+    void _addToken(TokenKind kind);
+
+private:
+    // Enough tokens for the '>>' lookback, which inspects at most the last 5.
+    static constexpr size_t kTokenHistory = 8;
+
+    void _scanNext();
+
+    bool _skipComment();
+
+    void _scanIdentifier();
+
+    void _scanNumber(char c);
+
+    void _addNumber(TokenKind kind, uint32_t bits);
+
+    // Decodes a float literal, without its suffix, to the bits of an f32.
+    uint32_t _decodeFloat(std::string_view digits, bool hex) const;
+
+    // Decodes the numeric literal, or interns the identifier, the legacy scanner just added.
+    void _finishLegacyToken();
+
+    bool _isTemplateClose();
+
+    // Reports an error about the token being scanned.
+    void _error(Diagnostic::Kind kind, const std::string &message) const;
+
 private:
-    std::string _source;
+    WgslScanner(const std::shared_ptr<const std::string> &source, Mode mode);
+
+    WgslScanner(std::shared_ptr<const void> storage, std::string_view source, Mode mode);
+
+    // Owns the memory _source views: a copy of the source string, or a file mapping.
+    std::shared_ptr<const void> _storage;
+    std::string_view _source;
+    Mode _mode;
+    SymbolTable *_symbols = nullptr;
+    std::vector<Diagnostic> *_diagnostics = nullptr;
     std::vector<Token> _tokens{};
     size_t _start = 0;
     size_t _current = 0;
     size_t _line = 1;
+    size_t _attrDepth = 0;
 };
 
 #endif //WGSL_INTROSPECTOR_WGSL_SCANNER_H
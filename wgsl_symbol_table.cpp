@@ -0,0 +1,84 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_symbol_table.h"
+
+#include <cstring>
+
+const Symbol *SymbolTable::intern(std::string_view text) {
+    // Keep the table at most half full.
+    if ((_symbols.size() + 1) * 2 > _slots.size())
+        _grow();
+
+    const uint32_t hash = _hash(text);
+    const size_t slot = _slot(text, hash);
+    if (_slots[slot] != 0)
+        return symbol(_slots[slot]);
+
+    const auto id = static_cast<uint32_t>(_symbols.size() + 1);
+    _symbols.push_back({id, _store(text)});
+    _hashes.push_back(hash);
+    _slots[slot] = id;
+    return &_symbols.back();
+}
+
+const Symbol *SymbolTable::find(std::string_view text) const {
+    if (_slots.empty())
+        return nullptr;
+    const size_t slot = _slot(text, _hash(text));
+    return _slots[slot] != 0 ? symbol(_slots[slot]) : nullptr;
+}
+
+uint32_t SymbolTable::_hash(std::string_view text) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char c: text) {
+        hash ^= uint8_t(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t SymbolTable::_slot(std::string_view text, uint32_t hash) const {
+    const size_t mask = _slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const uint32_t id = _slots[slot];
+        if (id == 0 || (_hashes[id - 1] == hash && _symbols[id - 1].text == text))
+            return slot;
+    }
+}
+
+void SymbolTable::_grow() {
+    _slots.assign(_slots.empty() ? 256 : _slots.size() * 2, 0);
+    const size_t mask = _slots.size() - 1;
+    for (uint32_t id = 1; id <= _symbols.size(); ++id) {
+        size_t slot = _hashes[id - 1] & mask;
+        while (_slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        _slots[slot] = id;
+    }
+}
+
+std::string_view SymbolTable::_store(std::string_view text) {
+    if (text.empty())
+        return {};
+    // Large text gets a block of its own, which goes before the block being filled.
+    if (text.size() > kBlockSize / 4) {
+        std::unique_ptr<char[]> block(new char[text.size()]);
+        std::memcpy(block.get(), text.data(), text.size());
+        const std::string_view stored{block.get(), text.size()};
+        _blocks.insert(_blocks.empty() ? _blocks.end() : _blocks.end() - 1, std::move(block));
+        return stored;
+    }
+    if (text.size() > kBlockSize - _blockUsed) {
+        _blocks.emplace_back(new char[kBlockSize]);
+        _blockUsed = 0;
+    }
+    char *data = _blocks.back().get() + _blockUsed;
+    std::memcpy(data, text.data(), text.size());
+    _blockUsed += text.size();
+    return {data, text.size()};
+}
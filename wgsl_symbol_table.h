@@ -0,0 +1,75 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_SYMBOL_TABLE_H
+#define WGSL_INTROSPECTOR_WGSL_SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+//MARK: - Symbol
+// An interned string. A SymbolTable has one Symbol per distinct string, so symbols of the same
+// table are equal exactly when their pointers are.
+struct Symbol {
+    uint32_t id;
+    std::string_view text;
+};
+
+//MARK: - SymbolTable
+// Interns the identifiers and other names of shaders. The text of the symbols is copied into
+// large blocks owned by the table, so symbols stay valid, and don't move, for as long as the
+// table lives. Not thread safe.
+class SymbolTable {
+public:
+    SymbolTable() = default;
+
+    SymbolTable(const SymbolTable &) = delete;
+
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    SymbolTable(SymbolTable &&) = default;
+
+    SymbolTable &operator=(SymbolTable &&) = default;
+
+    // Returns the symbol for text, adding it if it isn't in the table yet.
+    const Symbol *intern(std::string_view text);
+
+    // Returns the symbol for text, or nullptr if it was never interned.
+    [[nodiscard]] const Symbol *find(std::string_view text) const;
+
+    // Ids start at 1, so 0 can stand for "no symbol".
+    [[nodiscard]] const Symbol *symbol(uint32_t id) const {
+        return &_symbols[id - 1];
+    }
+
+    [[nodiscard]] size_t size() const {
+        return _symbols.size();
+    }
+
+private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    static uint32_t _hash(std::string_view text);
+
+    // The slot holding text, or the empty slot it would go to.
+    [[nodiscard]] size_t _slot(std::string_view text, uint32_t hash) const;
+
+    void _grow();
+
+    std::string_view _store(std::string_view text);
+
+    std::deque<Symbol> _symbols;
+    std::vector<uint32_t> _hashes;
+    // Open addressing with linear probing. A slot holds a symbol id, or 0 when empty.
+    std::vector<uint32_t> _slots;
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    size_t _blockUsed = kBlockSize;
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_SYMBOL_TABLE_H
@@ -0,0 +1,127 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#include "wgsl_thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+
+struct ThreadPool::Batch {
+    const std::function<void(size_t)> *task;
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    size_t failed = SIZE_MAX;
+    std::exception_ptr exception;
+};
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    for (size_t i = 0; i <= threads; ++i)
+        _queues.push_back(std::make_unique<Queue>());
+    _workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+        _workers.emplace_back([this, i]() {
+            _work(i);
+        });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker: _workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &task) {
+    if (count == 0)
+        return;
+
+    Batch batch;
+    batch.task = &task;
+    batch.remaining = count;
+    // Deal the tasks out round robin; idle workers steal from the busy ones.
+    for (size_t i = 0; i < count; ++i) {
+        auto &queue = *_queues[i % _queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.items.push_back({&batch, i});
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending += count;
+    }
+    _wake.notify_all();
+
+    const size_t self = _queues.size() - 1;
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        if (_runOne(self))
+            continue;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [&]() {
+            return batch.remaining.load(std::memory_order_acquire) == 0 || _pending.load() > 0;
+        });
+    }
+
+    if (batch.exception)
+        std::rethrow_exception(batch.exception);
+}
+
+void ThreadPool::_work(size_t self) {
+    for (;;) {
+        if (_runOne(self))
+            continue;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [&]() {
+            return _stop || _pending.load() > 0;
+        });
+        if (_stop)
+            return;
+    }
+}
+
+bool ThreadPool::_runOne(size_t self) {
+    for (size_t i = 0; i < _queues.size(); ++i) {
+        auto &queue = *_queues[(self + i) % _queues.size()];
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        if (queue.items.empty())
+            continue;
+        Item item;
+        if (i == 0) {
+            item = queue.items.front();
+            queue.items.pop_front();
+        } else {
+            item = queue.items.back();
+            queue.items.pop_back();
+        }
+        _pending--;
+        lock.unlock();
+        _run(item);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::_run(const Item &item) {
+    auto &batch = *item.batch;
+    try {
+        (*batch.task)(item.index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        if (item.index < batch.failed) {
+            batch.failed = item.index;
+            batch.exception = std::current_exception();
+        }
+    }
+    // The batch can be gone as soon as its last task is done, so it isn't touched after that.
+    if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wake.notify_all();
+    }
+}
@@ -0,0 +1,75 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_THREAD_POOL_H
+#define WGSL_INTROSPECTOR_WGSL_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//MARK: - ThreadPool
+// A work-stealing pool. Each worker has a queue it takes tasks from the front of; a worker whose
+// queue is empty steals from the back of the others. Threads that wait for their tasks run
+// tasks too, so tasks can wait for tasks of their own.
+class ThreadPool {
+public:
+    // With 0 threads, uses one worker less than the hardware has threads, as the calling thread
+    // works too.
+    explicit ThreadPool(size_t threads = 0);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool();
+
+    // The threads that run tasks: the workers, and a calling thread.
+    [[nodiscard]] size_t size() const {
+        return _workers.size() + 1;
+    }
+
+    // Runs task(0) to task(count - 1) on the pool and returns when all of them have run. If any
+    // throw, rethrows the exception of the lowest index, once all have run.
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+private:
+    struct Batch;
+
+    struct Item {
+        Batch *batch;
+        size_t index;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+
+    void _work(size_t self);
+
+    // Runs a task from queue self, or one stolen from another queue. Returns false if there was
+    // none.
+    bool _runOne(size_t self);
+
+    void _run(const Item &item);
+
+    // One queue per worker, and one last queue for the calling threads.
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<size_t> _pending{0};
+    std::mutex _mutex;
+    // Signaled when tasks are queued, when a batch is done, and on destruction.
+    std::condition_variable _wake;
+    bool _stop = false;
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_THREAD_POOL_H
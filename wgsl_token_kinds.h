@@ -0,0 +1,238 @@
+//  Copyright (c) 2022 Feng Yang
+//
+//  I am making my contributions/submissions to this project solely in my
+//  personal capacity and am not conveying any rights to any intellectual
+//  property of any third parties.
+
+#ifndef WGSL_INTROSPECTOR_WGSL_TOKEN_KINDS_H
+#define WGSL_INTROSPECTOR_WGSL_TOKEN_KINDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+// The token kinds of WGSL as X(Kind, "name") lists. Their order is the order of TokenKind,
+// and so of the ids in Token::Types: EOF, the tokens, the keywords, then the reserved words.
+
+// Tokens matched by the rules of Token::WgslTokens.
+#define WGSL_TOKENS(X) \
+        X(DecimalFloatLiteral, "decimal_float_literal") \
+        X(HexFloatLiteral, "hex_float_literal") \
+        X(IntLiteral, "int_literal") \
+        X(UintLiteral, "uint_literal") \
+        X(Ident, "ident") \
+        X(And, "and") \
+        X(AndAnd, "and_and") \
+        X(Arrow, "arrow") \
+        X(Attr, "attr") \
+        X(AttrLeft, "attr_left") \
+        X(AttrRight, "attr_right") \
+        X(ForwardSlash, "forward_slash") \
+        X(Bang, "bang") \
+        X(BracketLeft, "bracket_left") \
+        X(BracketRight, "bracket_right") \
+        X(BraceLeft, "brace_left") \
+        X(BraceRight, "brace_right") \
+        X(Colon, "colon") \
+        X(Comma, "comma") \
+        X(Equal, "equal") \
+        X(EqualEqual, "equal_equal") \
+        X(NotEqual, "not_equal") \
+        X(GreaterThan, "greater_than") \
+        X(GreaterThanEqual, "greater_than_equal") \
+        X(ShiftRight, "shift_right") \
+        X(LessThan, "less_than") \
+        X(LessThanEqual, "less_than_equal") \
+        X(ShiftLeft, "shift_left") \
+        X(Modulo, "modulo") \
+        X(Minus, "minus") \
+        X(MinusMinus, "minus_minus") \
+        X(Period, "period") \
+        X(Plus, "plus") \
+        X(PlusPlus, "plus_plus") \
+        X(Or, "or") \
+        X(OrOr, "or_or") \
+        X(ParenLeft, "paren_left") \
+        X(ParenRight, "paren_right") \
+        X(Semicolon, "semicolon") \
+        X(Star, "star") \
+        X(Tilde, "tilde") \
+        X(Underscore, "underscore") \
+        X(Xor, "xor")
+
+// Keywords, including the type names and texel formats.
+#define WGSL_KEYWORDS(X) \
+        X(Array, "array") \
+        X(Atomic, "atomic") \
+        X(Bool, "bool") \
+        X(F32, "f32") \
+        X(I32, "i32") \
+        X(Mat2x2, "mat2x2") \
+        X(Mat2x3, "mat2x3") \
+        X(Mat2x4, "mat2x4") \
+        X(Mat3x2, "mat3x2") \
+        X(Mat3x3, "mat3x3") \
+        X(Mat3x4, "mat3x4") \
+        X(Mat4x2, "mat4x2") \
+        X(Mat4x3, "mat4x3") \
+        X(Mat4x4, "mat4x4") \
+        X(Ptr, "ptr") \
+        X(Sampler, "sampler") \
+        X(SamplerComparison, "sampler_comparison") \
+        X(Struct, "struct") \
+        X(Texture1d, "texture_1d") \
+        X(Texture2d, "texture_2d") \
+        X(Texture2dArray, "texture_2d_array") \
+        X(Texture3d, "texture_3d") \
+        X(TextureCube, "texture_cube") \
+        X(TextureCubeArray, "texture_cube_array") \
+        X(TextureMultisampled2d, "texture_multisampled_2d") \
+        X(TextureStorage1d, "texture_storage_1d") \
+        X(TextureStorage2d, "texture_storage_2d") \
+        X(TextureStorage2dArray, "texture_storage_2d_array") \
+        X(TextureStorage3d, "texture_storage_3d") \
+        X(TextureDepth2d, "texture_depth_2d") \
+        X(TextureDepth2dArray, "texture_depth_2d_array") \
+        X(TextureDepthCube, "texture_depth_cube") \
+        X(TextureDepthCubeArray, "texture_depth_cube_array") \
+        X(TextureDepthMultisampled2d, "texture_depth_multisampled_2d") \
+        X(U32, "u32") \
+        X(Vec2, "vec2") \
+        X(Vec3, "vec3") \
+        X(Vec4, "vec4") \
+        X(Bitcast, "bitcast") \
+        X(Block, "block") \
+        X(Break, "break") \
+        X(Case, "case") \
+        X(Continue, "continue") \
+        X(Continuing, "continuing") \
+        X(Default, "default") \
+        X(Discard, "discard") \
+        X(Else, "else") \
+        X(Elseif, "elseif") \
+        X(Enable, "enable") \
+        X(Fallthrough, "fallthrough") \
+        X(False, "false") \
+        X(Fn, "fn") \
+        X(For, "for") \
+        X(Function, "function") \
+        X(If, "if") \
+        X(Let, "let") \
+        X(Loop, "loop") \
+        X(While, "while") \
+        X(Private, "private") \
+        X(Read, "read") \
+        X(ReadWrite, "read_write") \
+        X(Return, "return") \
+        X(Storage, "storage") \
+        X(Switch, "switch") \
+        X(True, "true") \
+        X(Type, "type") \
+        X(Uniform, "uniform") \
+        X(Var, "var") \
+        X(Workgroup, "workgroup") \
+        X(Write, "write") \
+        X(R8unorm, "r8unorm") \
+        X(R8snorm, "r8snorm") \
+        X(R8uint, "r8uint") \
+        X(R8sint, "r8sint") \
+        X(R16uint, "r16uint") \
+        X(R16sint, "r16sint") \
+        X(R16float, "r16float") \
+        X(Rg8unorm, "rg8unorm") \
+        X(Rg8snorm, "rg8snorm") \
+        X(Rg8uint, "rg8uint") \
+        X(Rg8sint, "rg8sint") \
+        X(R32uint, "r32uint") \
+        X(R32sint, "r32sint") \
+        X(R32float, "r32float") \
+        X(Rg16uint, "rg16uint") \
+        X(Rg16sint, "rg16sint") \
+        X(Rg16float, "rg16float") \
+        X(Rgba8unorm, "rgba8unorm") \
+        X(Rgba8unormSrgb, "rgba8unorm_srgb") \
+        X(Rgba8snorm, "rgba8snorm") \
+        X(Rgba8uint, "rgba8uint") \
+        X(Rgba8sint, "rgba8sint") \
+        X(Bgra8unorm, "bgra8unorm") \
+        X(Bgra8unormSrgb, "bgra8unorm_srgb") \
+        X(Rgb10a2unorm, "rgb10a2unorm") \
+        X(Rg11b10float, "rg11b10float") \
+        X(Rg32uint, "rg32uint") \
+        X(Rg32sint, "rg32sint") \
+        X(Rg32float, "rg32float") \
+        X(Rgba16uint, "rgba16uint") \
+        X(Rgba16sint, "rgba16sint") \
+        X(Rgba16float, "rgba16float") \
+        X(Rgba32uint, "rgba32uint") \
+        X(Rgba32sint, "rgba32sint") \
+        X(Rgba32float, "rgba32float")
+
+// Reserved words, which are scanned as keywords so they can't be used as identifiers.
+#define WGSL_RESERVED(X) \
+        X(Asm, "asm") \
+        X(Bf16, "bf16") \
+        X(Const, "const") \
+        X(Do, "do") \
+        X(Enum, "enum") \
+        X(F16, "f16") \
+        X(F64, "f64") \
+        X(Handle, "handle") \
+        X(I8, "i8") \
+        X(I16, "i16") \
+        X(I64, "i64") \
+        X(Mat, "mat") \
+        X(Premerge, "premerge") \
+        X(Regardless, "regardless") \
+        X(Typedef, "typedef") \
+        X(U8, "u8") \
+        X(U16, "u16") \
+        X(U64, "u64") \
+        X(Unless, "unless") \
+        X(Using, "using") \
+        X(Vec, "vec") \
+        X(Void, "void")
+
+enum class TokenKind : uint16_t {
+    Eof,
+#define WGSL_TOKEN_KIND(kind, name) kind,
+    WGSL_TOKENS(WGSL_TOKEN_KIND)
+    WGSL_KEYWORDS(WGSL_TOKEN_KIND)
+    WGSL_RESERVED(WGSL_TOKEN_KIND)
+#undef WGSL_TOKEN_KIND
+    Count
+};
+
+//MARK: - TokenKindSet
+// A set of token kinds, for the grammar rules that take any token of a group. Testing a kind is
+// a single bit test.
+class TokenKindSet {
+public:
+    constexpr TokenKindSet() = default;
+
+    constexpr TokenKindSet(std::initializer_list<TokenKind> kinds) {
+        for (const auto kind: kinds) {
+            const auto index = static_cast<size_t>(kind);
+            _words[index / 64] |= uint64_t(1) << (index % 64);
+        }
+    }
+
+    [[nodiscard]] constexpr bool contains(TokenKind kind) const {
+        const auto index = static_cast<size_t>(kind);
+        return (_words[index / 64] >> (index % 64)) & 1;
+    }
+
+    constexpr TokenKindSet operator|(const TokenKindSet &other) const {
+        TokenKindSet result;
+        for (size_t i = 0; i < kWords; ++i)
+            result._words[i] = _words[i] | other._words[i];
+        return result;
+    }
+
+private:
+    static constexpr size_t kWords = (static_cast<size_t>(TokenKind::Count) + 63) / 64;
+
+    uint64_t _words[kWords]{};
+};
+
+#endif //WGSL_INTROSPECTOR_WGSL_TOKEN_KINDS_H